@@ -1,4 +1,23 @@
-#include "CBack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dimacs.h"
+
+/// Maximum clique by an iterative branch and bound on bitsets: the search
+/// tree is the one of cback-maxclique.c (C <- C u {v} first, then P <- P \ {v},
+/// and backtrack when s + |P| <= LB), but the state of every level lives on
+/// an explicit stack, instead of being saved and restored by CBack at every
+/// choice point. The candidate set P of a level is a bitset, so that the
+/// candidates of a child are P & N(v). By default the bound is tightened
+/// with a greedy coloring of P (as in dfmax and MCQ): the vertices of P are
+/// branched on by decreasing color, and s + color(v) <= LB backtracks too.
+///
+/// usage: ./basic-maxclique [-b] [-c] [file]
+///   -b   only the bound s + |P| <= LB, i.e. the search of the CBack version
+///   -c   the file is the complement of the graph
+/// Without a file, the graph below is used.
 
 /// Complement of the graph for which
 /// we are looking for the maximum clique
@@ -6,9 +25,8 @@
 /// * E. Balas and J. Xue. Weighted and Unweighted Maximum Clique
 ///   Algorithms with Upper Bounds from Fraction Coloring.
 ///   Algorithmica, vol. 15, pp. 397-412, 1996.
-/// 
-int n=9;
-int E[] = { 
+///
+int E[] = {
    7, 8,
    4, 5, 6,
    3, 4, 8,
@@ -19,63 +37,249 @@ int E[] = {
 };
 int V[10] = { -1, 1, 4, 7, 10, 11, 12, 13, 13, 13};
 
+/// Graph: adjacency rows of w words each
+int     n = 9;
+int     w;
+word_t* adj;
+
 /// Global data to store the Maximum clique
-int LB = 0;
-int C[9] = {0};
+int     LB = 0;
+int*    C;
+long    nodes = 0;
 
-/// Print best clique
-void PrintCount()
-{ 
-   int i, j;
-   printf("Graph: \n");
+/// A level of the search, with s = (depth of the level) vertices in the
+/// clique: the candidates are branched on from order[len-1] down to
+/// order[0], and 'col[i]' bounds the clique in { order[0], ..., order[i] }
+typedef struct {
+   word_t*  P;
+   int*     order;
+   int*     col;
+   word_t*  Q;     /// Scratch of the coloring, 2w words
+   int      len;
+   int      v;     /// Vertex added to the clique by the current branch
+} level_t;
+
+level_t* level;
+
+/// Number of elements of a bitset
+static int count(const word_t* a) {
+   int i, c = 0;
+   for ( i = 0; i < w; i++ )
+      c += __builtin_popcountll(a[i]);
+   return c;
+}
+
+/// Prepare the branching of a level with 's' vertices in the clique
+static void setup(level_t* L, int s, int basic) {
+   int      i, k, v, m = count(L->P);
+   word_t*  Q;
+   word_t*  R;
+   L->len = 0;
+   if ( s + m <= LB )   /// The candidates cannot improve on C*
+      return;
+   if ( basic ) {
+      /// Smallest vertex first, with |P| as bound
+      for ( i = w-1; i >= 0; i-- ) {
+         word_t b = L->P[i];
+         while ( b ) {
+            v = 64*i + 63 - __builtin_clzll(b);
+            b &= ~((word_t)1 << (v & 63));
+            L->order[L->len] = v;
+            L->col[L->len] = L->len+1;
+            L->len++;
+         }
+      }
+      return;
+   }
+   /// Greedy coloring: each color class is a maximal independent set of
+   /// the uncolored candidates, taken in increasing order
+   Q = L->Q;
+   R = Q + w;
+   memcpy(Q, L->P, w*sizeof(word_t));
+   for ( k = 1; L->len < m; k++ ) {
+      memcpy(R, Q, w*sizeof(word_t));
+      for ( i = 0; i < w; i++ )
+         while ( R[i] ) {
+            int j;
+            v = 64*i + __builtin_ctzll(R[i]);
+            BS_DEL(Q, v);
+            for ( j = i; j < w; j++ )
+               R[j] &= ~adj[(size_t)v*w + j];
+            BS_DEL(R, v);
+            L->order[L->len] = v;
+            L->col[L->len] = k;
+            L->len++;
+         }
+   }
+}
+
+/// The coloring bound is tighter if the vertices of large degree come first
+/// (as in MCQ): 'perm[i]' is the original name of the vertex i
+int* perm = NULL;
+int* degree;
+
+static int by_degree(const void* a, const void* b) {
+   int u = *(const int*)a, v = *(const int*)b;
+   return (degree[v] != degree[u]) ? degree[v] - degree[u] : u - v;
+}
+
+void Renumber() {
+   int      i, j;
+   word_t*  a = (word_t*) calloc((size_t)n*w, sizeof(word_t));
+   perm = (int*) malloc(n*sizeof(int));
+   degree = (int*) malloc(n*sizeof(int));
    for ( i = 0; i < n; i++ ) {
-      printf("%d -> ", i);
-      for ( j = V[i+1]; j > V[i]; j-- )
-         printf("%d ", E[j]);
-      printf("\n");
+      perm[i] = i;
+      degree[i] = count(adj + (size_t)i*w);
    }
-   printf("w(G)=%d.\nClique: \t",LB); 
+   qsort(perm, n, sizeof(int), by_degree);
    for ( i = 0; i < n; i++ )
-      if ( C[i] == 1 )
-      printf("%d\t", i);
-   printf("\n");
+      for ( j = 0; j < n; j++ )
+         if ( BS_CONTAINS(adj + (size_t)perm[i]*w, perm[j]) )
+            BS_ADD(a + (size_t)i*w, j);
+   free(adj);
+   free(degree);
+   adj = a;
+}
+
+/// Back to the original names, in the best clique
+void Restore() {
+   int  i;
+   int* c = (int*) calloc(n, sizeof(int));
+   for ( i = 0; i < n; i++ )
+      c[perm[i]] = C[i];
+   free(C);
+   free(perm);
+   C = c;
 }
 
 /// Basic implementation of a max clique algorithm
-void MaxClique() {
-   int v, w;
-   int P = n;  /// Size of the candidate set
-   int s = 0;  /// Size of the current clique
-   int* S;
-   Fiasco = PrintCount;
-   S = (int*) Ncalloc(n, sizeof(int));
-   for (v = 0; v < n; v++ ) {
+void MaxClique(int basic) {
+   int       d = 0, i, j, v;
+   level_t*  L;
+   level_t*  L1;
+
+   level = (level_t*) calloc(n+1, sizeof(level_t));
+   level[0].P = (word_t*) calloc(w, sizeof(word_t));
+   level[0].order = (int*) malloc(n*sizeof(int));
+   level[0].col = (int*) malloc(n*sizeof(int));
+   level[0].Q = (word_t*) malloc(2*w*sizeof(word_t));
+   for ( v = 0; v < n; v++ )
+      BS_ADD(level[0].P, v);
+   setup(&level[0], 0, basic);
+
+   while ( d >= 0 ) {
+      L = &level[d];
+      i = L->len-1;
       /// If the current clique cannot be extended to a clique
       /// larger than C*, where LB=|C*|, then backtrack
-      if ( s + P <= LB )
-         Backtrack();
-      /// Skip removed vertices
-      if ( S[v] < 2 ) {
-         /// Choice: Either v is in C (S[v]=1) or is not (S[v]=2)
-         S[v] = Choice(2);  
-         if ( S[v] == 2 ) {  /// P <- P \ {v} 
-            P--;    /// Decrease the size of the candidate set 
-         } else {   /// S[v]=1: C <- C u {v}
-            s++;    /// Update current clique size
-            if ( s > LB ) {
-               LB = s;   /// Store the new best clique
-               for ( w = 0; w <= v; w++ )
-                  C[w] = S[w];
-            }
-            for ( w = V[v+1]; w > V[v] ; w-- ) 
-               if ( S[E[w]] == 0 ) {
-                  S[E[w]] = 2;
-                  P--; /// Decrease the size of the candidate set
-               }
-         } 
+      if ( i < 0 || d + L->col[i] <= LB ) {
+         if ( --d >= 0 )   /// P <- P \ {v} in the parent
+            BS_DEL(level[d].P, level[d].v);
+         continue;
+      }
+      /// C <- C u {v}
+      v = L->order[i];
+      L->len--;
+      L->v = v;
+      nodes++;
+      if ( d+1 > LB ) {
+         LB = d+1;   /// Store the new best clique
+         memset(C, 0, n*sizeof(int));
+         for ( j = 0; j <= d; j++ )
+            C[level[j].v] = 1;
+      }
+      /// Restrict the candidate set: P & N(v)
+      L1 = &level[d+1];
+      if ( L1->P == NULL ) {
+         L1->P = (word_t*) malloc(w*sizeof(word_t));
+         L1->order = (int*) malloc(n*sizeof(int));
+         L1->col = (int*) malloc(n*sizeof(int));
+         L1->Q = (word_t*) malloc(2*w*sizeof(word_t));
+      }
+      for ( j = 0; j < w; j++ )
+         L1->P[j] = L->P[j] & adj[(size_t)v*w + j];
+      setup(L1, d+1, basic);
+      if ( L1->len > 0 )
+         d++;
+      else
+         BS_DEL(L->P, v);
+   }
+
+   for ( d = 0; d <= n; d++ ) {
+      free(level[d].P);
+      free(level[d].order);
+      free(level[d].col);
+      free(level[d].Q);
+   }
+   free(level);
+}
+
+/// Print best clique
+void PrintCount(int example, double time)
+{
+   int i, j;
+   if ( example ) {
+      printf("Graph: \n");
+      for ( i = 0; i < n; i++ ) {
+         printf("%d -> ", i);
+         for ( j = V[i+1]; j > V[i]; j-- )
+            printf("%d ", E[j]);
+         printf("\n");
       }
    }
-   Backtrack();
+   printf("w(G)=%d.\nClique: \t",LB);
+   for ( i = 0; i < n; i++ )
+      if ( C[i] == 1 )
+      printf("%d\t", i);
+   printf("\nNodes: %ld Time: %.3f\n", nodes, time);
 }
 
-main() Backtracking(MaxClique())
+int main(int argc, char** argv) {
+   int      basic = 0, complement = 0, i, j, v;
+   char*    file = NULL;
+   clock_t  start;
+
+   for ( i = 1; i < argc; i++ ) {
+      if ( strcmp(argv[i], "-b") == 0 )
+         basic = 1;
+      else if ( strcmp(argv[i], "-c") == 0 )
+         complement = 1;
+      else
+         file = argv[i];
+   }
+   if ( file != NULL ) {
+      adj = read_dimacs(file, complement, &n);
+      if ( adj == NULL ) {
+         fprintf(stderr, "Cannot read the graph %s\n", file);
+         exit(EXIT_FAILURE);
+      }
+      w = BS_WORDS(n);
+   } else {
+      /// The example is the complement of the graph
+      w = BS_WORDS(n);
+      adj = (word_t*) calloc((size_t)n*w, sizeof(word_t));
+      for ( v = 0; v < n; v++ )
+         for ( j = 0; j < n; j++ )
+            if ( j != v )
+               BS_ADD(adj + (size_t)v*w, j);
+      for ( v = 0; v < n; v++ )
+         for ( j = V[v+1]; j > V[v]; j-- ) {
+            BS_DEL(adj + (size_t)v*w, E[j]);
+            BS_DEL(adj + (size_t)E[j]*w, v);
+         }
+   }
+   C = (int*) calloc(n, sizeof(int));
+
+   start = clock();
+   if ( !basic )
+      Renumber();
+   MaxClique(basic);
+   if ( !basic )
+      Restore();
+   PrintCount(file == NULL, (double)(clock()-start)/CLOCKS_PER_SEC);
+
+   free(C);
+   free(adj);
+   return EXIT_SUCCESS;
+}
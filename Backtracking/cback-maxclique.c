@@ -0,0 +1,175 @@
+#include <string.h>
+#include <time.h>
+
+#include "CBack.h"
+#include "dimacs.h"
+
+/// The CBack version of basic-maxclique.c, kept as the reference of the
+/// benchmark: both explore the same search tree with the -b option of
+/// basic-maxclique, so the difference in time is the cost of saving and
+/// restoring the C stack at every Choice.
+///
+/// usage: ./cback-maxclique [-c] [-j threads] [-d depth] [file]
+///   -c   the file is the complement of the graph
+///   -j   threads of the parallel mode of the runtime in trail/ (default 1)
+///   -d   choices split into parallel jobs (default 12)
+/// Without a file, the graph below is used.
+
+#ifndef CBACK_PARALLEL
+/// The original CBack is sequential
+#define Share(B, M)
+#define Improve(B, V)  (*(B) = (V), 1)
+#define Exclusive(S)   { S; }
+#endif
+
+/// Complement of the graph for which
+/// we are looking for the maximum clique
+/// Graph taken from:
+/// * E. Balas and J. Xue. Weighted and Unweighted Maximum Clique
+///   Algorithms with Upper Bounds from Fraction Coloring.
+///   Algorithmica, vol. 15, pp. 397-412, 1996.
+///
+int n=9;
+int E0[] = {
+   7, 8,
+   4, 5, 6,
+   3, 4, 8,
+   5, 6, 7,
+   8,
+   7,
+   7
+};
+int V0[10] = { -1, 1, 4, 7, 10, 11, 12, 13, 13, 13};
+
+/// Complement of the graph as lists: the vertices after v that are not
+/// adjacent to v are E[w], for V[v] < w <= V[v+1]
+int* E = E0;
+int* V = V0;
+
+/// Global data to store the Maximum clique
+int LB = 0;
+int* C;
+long nodes = 0;
+int example = 1;
+struct timespec start;
+
+int Max(int a, int b) {
+   return a > b ? a : b;
+}
+
+double Elapsed() {
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return (t.tv_sec - start.tv_sec) + 1e-9*(t.tv_nsec - start.tv_nsec);
+}
+
+/// Print best clique
+void PrintCount()
+{
+   int i, j;
+   if ( example ) {
+      printf("Graph: \n");
+      for ( i = 0; i < n; i++ ) {
+         printf("%d -> ", i);
+         for ( j = V[i+1]; j > V[i]; j-- )
+            printf("%d ", E[j]);
+         printf("\n");
+      }
+   }
+   printf("w(G)=%d.\nClique: \t",LB);
+   for ( i = 0; i < n; i++ )
+      if ( C[i] == 1 )
+      printf("%d\t", i);
+   printf("\nNodes: %ld Time: %.3f\n", nodes, Elapsed());
+}
+
+/// Basic implementation of a max clique algorithm
+void MaxClique() {
+   int v, w;
+   int P = n;  /// Size of the candidate set
+   int s = 0;  /// Size of the current clique
+   int* S;
+   Fiasco = PrintCount;
+   S = (int*) Ncalloc(n, sizeof(int));
+   for (v = 0; v < n; v++ ) {
+      /// If the current clique cannot be extended to a clique
+      /// larger than C*, where LB=|C*|, then backtrack
+      if ( s + P <= LB )
+         Backtrack();
+      /// Skip removed vertices
+      if ( S[v] < 2 ) {
+         /// Choice: Either v is in C (S[v]=1) or is not (S[v]=2)
+         S[v] = Choice(2);
+         if ( S[v] == 2 ) {  /// P <- P \ {v}
+            P--;    /// Decrease the size of the candidate set
+         } else {   /// S[v]=1: C <- C u {v}
+            __atomic_add_fetch(&nodes, 1, __ATOMIC_RELAXED);
+            s++;    /// Update current clique size
+            P--;    /// v leaves the candidate set
+            if ( s > LB && Improve(&LB, s) ) {
+               /// Store the new best clique, unless a larger one came first
+               Exclusive(
+                  if ( LB == s )
+                     for ( w = 0; w < n; w++ )
+                        C[w] = S[w];
+               )
+            }
+            for ( w = V[v+1]; w > V[v] ; w-- )
+               if ( S[E[w]] == 0 ) {
+                  S[E[w]] = 2;
+                  P--; /// Decrease the size of the candidate set
+               }
+         }
+      }
+   }
+   Backtrack();
+}
+
+int main(int argc, char** argv) {
+   int      complement = 0, threads = 1, depth = 12, i, u, v, m = 0;
+   char*    file = NULL;
+   word_t*  adj;
+   int      w;
+
+   for ( i = 1; i < argc; i++ ) {
+      if ( strcmp(argv[i], "-c") == 0 )
+         complement = 1;
+      else if ( strcmp(argv[i], "-j") == 0 && i+1 < argc )
+         threads = atoi(argv[++i]);
+      else if ( strcmp(argv[i], "-d") == 0 && i+1 < argc )
+         depth = atoi(argv[++i]);
+      else
+         file = argv[i];
+   }
+   if ( file != NULL ) {
+      /// The lists hold the complement of the graph read
+      adj = read_dimacs(file, !complement, &n);
+      if ( adj == NULL ) {
+         fprintf(stderr, "Cannot read the graph %s\n", file);
+         exit(EXIT_FAILURE);
+      }
+      w = BS_WORDS(n);
+      V = (int*) malloc((n+1)*sizeof(int));
+      E = (int*) malloc(((size_t)n*(n-1)/2+1)*sizeof(int));
+      V[0] = -1;
+      for ( v = 0; v < n; v++ ) {
+         for ( u = v+1; u < n; u++ )
+            if ( BS_CONTAINS(adj + (size_t)v*w, u) )
+               E[m++] = u;
+         V[v+1] = m-1;
+      }
+      free(adj);
+      example = 0;
+   }
+   C = (int*) calloc(n, sizeof(int));
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   Share(&LB, Max);
+#ifdef CBACK_PARALLEL
+   if ( threads > 1 ) {
+      ParallelBacktracking(MaxClique, threads, depth);
+      return EXIT_SUCCESS;
+   }
+#endif
+   Backtracking(MaxClique());
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+/// Read a graph in the ASCII DIMACS format ("p edge n m" and "e u v" lines,
+/// with vertices from 1 to n), as an adjacency matrix of bitsets: row v has
+/// BS_WORDS(n) words, and the bit u of row v is set if {u,v} is an edge.
+/// With 'complement' set, the rows are those of the complement graph.
+/// Loops are dropped; returns NULL if the file cannot be read.
+#ifndef _DIMACS_H_
+#define _DIMACS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef uint64_t word_t;
+
+#define BS_WORDS(n)        (((n)+63) >> 6)
+#define BS_CONTAINS(b,i)   (((b)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BS_ADD(b,i)        ((b)[(i) >> 6] |= ((word_t)1 << ((i) & 63)))
+#define BS_DEL(b,i)        ((b)[(i) >> 6] &= ~((word_t)1 << ((i) & 63)))
+
+static word_t* read_dimacs(const char* name, int complement, int* n) {
+   FILE*    fp = fopen(name, "r");
+   char     line[1024];
+   word_t*  adj = NULL;
+   int      u, v, w = 0;
+
+   *n = 0;
+   if ( fp == NULL )
+      return NULL;
+   while ( fgets(line, sizeof(line), fp) != NULL ) {
+      if ( line[0] == 'p' && adj == NULL ) {
+         if ( sscanf(line, "p %*s %d", n) != 1 || *n <= 0 )
+            break;
+         w = BS_WORDS(*n);
+         adj = (word_t*) calloc((size_t)(*n)*w, sizeof(word_t));
+      }
+      else if ( line[0] == 'e' && adj != NULL && sscanf(line, "e %d %d", &u, &v) == 2 ) {
+         if ( u < 1 || v < 1 || u > *n || v > *n || u == v )
+            continue;
+         BS_ADD(adj + (size_t)(u-1)*w, v-1);
+         BS_ADD(adj + (size_t)(v-1)*w, u-1);
+      }
+   }
+   fclose(fp);
+   if ( adj != NULL && complement )
+      for ( v = 0; v < *n; ++v )
+         for ( u = 0; u < *n; ++u )
+            if ( u != v ) {
+               if ( BS_CONTAINS(adj + (size_t)v*w, u) )
+                  BS_DEL(adj + (size_t)v*w, u);
+               else
+                  BS_ADD(adj + (size_t)v*w, u);
+            }
+   return adj;
+}
+
+#endif /* _DIMACS_H_ */
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CBack.h"
+
+/// Number of solutions of the N-queens problem, with the parallel mode of
+/// the runtime in trail/: one queen per row, placed by Choice(n)
+///
+/// usage: ./queens [n] [threads] [depth]
+
+int n = 8;
+int Solutions = 0;
+struct timespec start;
+
+int Sum(int a, int b) {
+   return a + b;
+}
+
+void PrintCount() {
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   printf("Queens: %d Solutions: %d Time: %.3f\n", n, Solutions,
+         (t.tv_sec - start.tv_sec) + 1e-9*(t.tv_nsec - start.tv_nsec));
+}
+
+void Queens() {
+   int   i, j;
+   /// Columns and diagonals under attack
+   char* col = (char*) Ncalloc(n, 1);
+   char* up = (char*) Ncalloc(2*n, 1);
+   char* down = (char*) Ncalloc(2*n, 1);
+   Fiasco = PrintCount;
+   for ( i = 0; i < n; i++ ) {
+      j = Choice(n) - 1;
+      if ( col[j] || up[i+j] || down[i-j+n] )
+         Backtrack();
+      col[j] = up[i+j] = down[i-j+n] = 1;
+   }
+   Improve(&Solutions, 1);
+   Backtrack();
+}
+
+int main(int argc, char** argv) {
+   int threads = 1, depth = 2;
+   if ( argc > 1 )
+      n = atoi(argv[1]);
+   if ( argc > 2 )
+      threads = atoi(argv[2]);
+   if ( argc > 3 )
+      depth = atoi(argv[3]);
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   Share(&Solutions, Sum);
+   if ( threads > 1 )
+      ParallelBacktracking(Queens, threads, depth);
+   else
+      Backtracking(Queens());
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,745 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Backtracking runtime with the API of CBack (see CBack.h)
+ */
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <alloca.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "CBack.h"
+
+/// Areas of at least COW_MIN bytes are trailed by pages, the smaller ones
+/// are copied at every choice point
+#ifndef COW_MIN
+#define COW_MIN   (64*1024)
+#endif
+
+/// A stack segment of at least STACK_COW_MIN bytes is trailed by pages too,
+/// but for the part in the page of the Choice frame, which is copied (at
+/// most a page): the shorter ones are copied, since a fault costs more
+#ifndef STACK_COW_MIN
+#define STACK_COW_MIN   (64*1024)
+#endif
+
+/// Size of the signal stack of a thread with a trailed stack
+#define ALTSTACK  (64*1024)
+
+/// Stack mapped below a choice point before its pages are protected
+#define STACK_MARGIN  (16*1024)
+
+#define NONE      ((size_t)-1)
+
+void (*Fiasco)() = NULL;
+__thread char* StackBottom = NULL;
+
+/// A notified area: the pages in [lo, hi) are trailed on write, the rest
+/// [base, lo) and [hi, base+size) is copied at every choice point
+typedef struct {
+   char*    base;
+   size_t   size;
+   char*    lo;
+   char*    hi;
+} area_t;
+
+/// A choice point, followed in the arena by the copy of the stack segment
+/// [low, low+stack) and by the copies of the areas, in their order. The
+/// stack pages from cow up to StackBottom are trailed
+typedef struct {
+   jmp_buf  env;
+   int      n;        /* alternatives */
+   int      next;     /* next value to return */
+   char*    low;
+   size_t   stack;
+   char*    cow;      /* lowest trailed stack page of this and older choices */
+   int      nareas;   /* areas notified before the choice point */
+   int      level;    /* choices with N > 1 above this one */
+   size_t   prev;     /* offset of the previous choice point */
+   size_t   pages;    /* pages in the trail before the choice point */
+} choice_t;
+
+/// The state of the runtime is per thread: in the parallel mode every
+/// worker runs its own sequential search
+static __thread char*     A = NULL;        /* arena of the choice points */
+static __thread size_t    used = 0, cap = 0;
+static __thread size_t    top = NONE;      /* offset of the most recent choice point */
+static __thread int       level = 0;       /* choices with N > 1 on the current path */
+
+static __thread area_t*   areas = NULL;
+static __thread int       nareas = 0, maxareas = 0;
+
+static __thread char**    tpage = NULL;    /* trail of the pages: address and copy */
+static __thread char*     tdata = NULL;
+static __thread size_t    tused = 0, tcap = 0;
+
+static __thread int       writable = 0;    /* some page of an area is not protected */
+
+/// Trailed stack pages: [sprot, stop) is protected, but for the nopen pages
+/// in sopen (all of them, if nopen > MAX_OPEN), and all the stack pages on
+/// the trail are in [smin, stop)
+#define MAX_OPEN  64
+
+static __thread char*     stop = NULL;
+static __thread char*     sprot = NULL;
+static __thread char*     smin = NULL;
+static __thread char*     sopen[MAX_OPEN];
+static __thread int       nopen = 0;
+static __thread char*     altstack = NULL;
+static __thread char*     sgrown = NULL;   /* lowest stack address mapped */
+static size_t             pagesize = 0;
+static struct sigaction   old_action;
+
+#define CHOICE(off)   ((choice_t*)(A + (off)))
+
+static void fail(const char* msg) {
+   fprintf(stderr, "CBack: %s\n", msg);
+   exit(EXIT_FAILURE);
+}
+
+/// Reserve 'n' bytes at the end of the arena (which may move)
+static size_t grow(size_t n) {
+   size_t off = used;
+   if ( used + n > cap ) {
+      cap = 2*cap + n + 4096;
+      A = (char*) realloc(A, cap);
+      if ( A == NULL )
+         fail("out of memory");
+   }
+   used += n;
+   return off;
+}
+
+#define STACK_PAGE(p)  ((p) >= smin && (p) < stop)
+
+/// The trail grows in the fault handler, which may interrupt malloc (its
+/// frames are on trailed stack pages): it is mapped and remapped directly
+static void* remap(void* p, size_t old, size_t size) {
+   if ( p == NULL )
+      p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   else
+      p = mremap(p, old, size, MREMAP_MAYMOVE);
+   if ( p == MAP_FAILED )
+      fail("out of memory");
+   return p;
+}
+
+/// Protect the trailed pages, so that the first write after a choice point
+/// copies the page to the trail. The stack pages trailed are the ones of the
+/// live choice points: only the pages written since the last call, and the
+/// ones the range gains, are protected again
+static void protect(void) {
+   char* lo = (top != NONE) ? CHOICE(top)->cow : stop;
+   char* old = sprot;
+   int   i, n = nopen;
+   sprot = lo;
+   if ( lo < smin )
+      smin = lo;
+   if ( writable ) {
+      writable = 0;
+      for ( i = 0; i < nareas; i++ )
+         if ( areas[i].lo < areas[i].hi )
+            mprotect(areas[i].lo, areas[i].hi - areas[i].lo, PROT_READ);
+   }
+   /// This frame may be on a page protected here: the pages reopened by its
+   /// writes are appended to sopen, and they stay there
+   if ( n > MAX_OPEN ) {
+      nopen = 0;
+      if ( lo < stop )
+         mprotect(lo, stop - lo, PROT_READ);
+   } else {
+      for ( i = 0; i < n; i++ )
+         if ( sopen[i] >= lo )
+            mprotect(sopen[i], pagesize, PROT_READ);
+      if ( lo < old )
+         mprotect(lo, old - lo, PROT_READ);
+      for ( i = n; i < nopen && i < MAX_OPEN; i++ )
+         sopen[i-n] = sopen[i];
+      nopen -= n;
+   }
+   if ( lo > old )
+      mprotect(old, lo - old, PROT_READ | PROT_WRITE);
+}
+
+/// A stack page writable until the next protect
+static void reopen(char* page) {
+   mprotect(page, pagesize, PROT_READ | PROT_WRITE);
+   if ( nopen < MAX_OPEN )
+      sopen[nopen] = page;
+   nopen++;
+}
+
+/// All the stack pages writable again
+static void unprotect_stack(void) {
+   if ( sprot < stop )
+      mprotect(sprot, stop - sprot, PROT_READ | PROT_WRITE);
+   sprot = stop;
+   nopen = 0;
+}
+
+/// First write to a protected page: the page goes on the trail (only if a
+/// choice point may restore it) and becomes writable. The faults are
+/// synchronous, raised by the program writing its own storage or its stack
+/// (the handler runs on the signal stack), so the trail may grow here
+static void on_write(int sig, siginfo_t* si, void* ctx) {
+   char* a = (char*)si->si_addr;
+   char* page;
+   int   i;
+   (void)sig;
+   (void)ctx;
+   for ( i = 0; i <= nareas; i++ )
+      if ( (i < nareas) ? (a >= areas[i].lo && a < areas[i].hi) : STACK_PAGE(a) ) {
+         page = (char*)((uintptr_t)a & ~(uintptr_t)(pagesize-1));
+         if ( top != NONE ) {
+            if ( tused == tcap ) {
+               tpage = (char**) remap(tpage, tcap*sizeof(char*), (2*tcap + 64)*sizeof(char*));
+               tdata = (char*) remap(tdata, tcap*pagesize, (2*tcap + 64)*pagesize);
+               tcap = 2*tcap + 64;
+            }
+            tpage[tused] = page;
+            memcpy(tdata + tused*pagesize, page, pagesize);
+            tused++;
+         }
+         if ( i == nareas )
+            reopen(page);
+         else {
+            mprotect(page, pagesize, PROT_READ | PROT_WRITE);
+            writable = 1;
+         }
+         return;
+      }
+   /// Not a trailed page: the fault is raised again with the old handler
+   sigaction(SIGSEGV, &old_action, NULL);
+}
+
+static void install(void) {
+   struct sigaction sa;
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_sigaction = on_write;
+   sa.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGSEGV, &sa, &old_action);
+}
+
+/// Parallel mode: a job is the sequence of the values of the first Choice
+/// calls (with N > 1) of the model. A worker replays them, and then it
+/// splits the choices up to the level 'split' into new jobs, and searches
+/// the rest sequentially
+typedef struct {
+   int      len;
+   int      path[];
+} job_t;
+
+/// Work-stealing deque of a worker: the owner pushes and pops at the
+/// tail, the thieves take the oldest jobs (the largest subtrees) at the head
+typedef struct {
+   pthread_mutex_t  lock;
+   job_t**          job;
+   int              head, tail, cap;
+} deque_t;
+
+static deque_t*         deques = NULL;
+static int              nworkers = 0;
+static int              split = 0;
+static long             pending = 0;     /* jobs not yet finished */
+static void           (*model)(void) = NULL;
+
+static __thread job_t*  job = NULL;      /* job of the worker, NULL if sequential */
+static __thread int*    path = NULL;     /* values of the choices up to 'split' */
+static __thread int     me = 0;
+static __thread jmp_buf finished;
+static __thread void**  allocs = NULL;   /* NotifyAlloc of the current job */
+static __thread int     nallocs = 0, maxallocs = 0;
+
+static void push(deque_t* D, job_t* J) {
+   __atomic_add_fetch(&pending, 1, __ATOMIC_ACQ_REL);
+   pthread_mutex_lock(&D->lock);
+   if ( D->tail == D->cap ) {
+      memmove(D->job, D->job + D->head, (D->tail - D->head)*sizeof(job_t*));
+      D->tail -= D->head;
+      D->head = 0;
+      if ( D->tail == D->cap ) {
+         D->cap = 2*D->cap + 64;
+         D->job = (job_t**) realloc(D->job, D->cap*sizeof(job_t*));
+         if ( D->job == NULL )
+            fail("out of memory");
+      }
+   }
+   D->job[D->tail++] = J;
+   pthread_mutex_unlock(&D->lock);
+}
+
+static job_t* pop(deque_t* D, int steal) {
+   job_t* J = NULL;
+   pthread_mutex_lock(&D->lock);
+   if ( D->head < D->tail )
+      J = steal ? D->job[D->head++] : D->job[--D->tail];
+   pthread_mutex_unlock(&D->lock);
+   return J;
+}
+
+/// A choice above the level 'split': the values 2..N become new jobs, and
+/// the worker goes on with 1
+static unsigned int Split(const int N) {
+   int    d = level++, v;
+   job_t* J;
+   if ( d < job->len )   /// Replay of the prefix of the job
+      return path[d] = job->path[d];
+   for ( v = N; v >= 2; v-- ) {
+      J = (job_t*) malloc(sizeof(job_t) + (d+1)*sizeof(int));
+      if ( J == NULL )
+         fail("out of memory");
+      J->len = d+1;
+      memcpy(J->path, path, d*sizeof(int));
+      J->path[d] = v;
+      push(&deques[me], J);
+   }
+   return path[d] = 1;
+}
+
+static unsigned int Resume(void) {
+   choice_t*    C = CHOICE(top);
+   unsigned int v = C->next++;
+   level = C->level + 1;
+   if ( v >= (unsigned int)C->n ) {   /// Last value: the choice point is removed
+      used = top;
+      top = C->prev;
+   }
+   return v;
+}
+
+/// Save the stack segment between this frame (below the one of Choice) and
+/// StackBottom: if it is long, the part in the page of this frame is copied
+/// and the older pages are trailed from now on, else all of it is copied.
+/// Then copy the areas copied at each choice point
+static void __attribute__((noinline)) SaveState(size_t off) {
+   volatile char  here;
+   char*          low = (char*)&here;
+   char*          cow;
+   size_t         n, m = 0, p;
+   int            i;
+   if ( StackBottom == NULL || StackBottom < low )
+      fail("Choice called outside of Backtracking()");
+   if ( pagesize == 0 )
+      pagesize = sysconf(_SC_PAGESIZE);
+   if ( stop == NULL )
+      stop = sprot = smin = (char*)(((uintptr_t)StackBottom + pagesize) & ~(uintptr_t)(pagesize-1));
+   cow = (char*)((uintptr_t)low & ~(uintptr_t)(pagesize-1)) + pagesize;
+   if ( cow > StackBottom || (size_t)(StackBottom - low) < STACK_COW_MIN )
+      cow = stop;
+   n = (cow > StackBottom ? StackBottom + 1 : cow > low ? cow : low) - low;
+   /// The main stack grows on demand from its lowest page, which would take
+   /// the protection of a trailed page: the stack is mapped well below the
+   /// trailed pages, so that it never grows from one of them
+   if ( sgrown == NULL || (uintptr_t)low < (uintptr_t)sgrown + STACK_MARGIN ) {
+      volatile char* pad = (volatile char*) alloca(STACK_MARGIN);
+      for ( p = 0; p < STACK_MARGIN; p += 64 )
+         pad[p] = 0;
+      sgrown = (char*)pad;
+   }
+   if ( cow < stop && altstack == NULL ) {
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      stack_t ss;
+      altstack = (char*) malloc(ALTSTACK);
+      if ( altstack == NULL )
+         fail("out of memory");
+      ss.ss_sp = altstack;
+      ss.ss_size = ALTSTACK;
+      ss.ss_flags = 0;
+      sigaltstack(&ss, NULL);
+      pthread_once(&once, install);
+   }
+   if ( CHOICE(off)->prev != NONE && CHOICE(CHOICE(off)->prev)->cow < cow )
+      cow = CHOICE(CHOICE(off)->prev)->cow;
+   for ( i = 0; i < nareas; i++ )
+      m += areas[i].size - (areas[i].hi - areas[i].lo);
+   p = grow(n + m);
+   CHOICE(off)->low = low;
+   CHOICE(off)->stack = n;
+   CHOICE(off)->cow = cow;
+   memcpy(A + p, low, n);
+   p += n;
+   for ( i = 0; i < nareas; i++ ) {
+      area_t* a = &areas[i];
+      memcpy(A + p, a->base, a->lo - a->base);
+      p += a->lo - a->base;
+      memcpy(A + p, a->hi, a->base + a->size - a->hi);
+      p += a->base + a->size - a->hi;
+   }
+}
+
+/// Copy back the stack pages written after the choice point and its stack
+/// segment, and resume it. The frame of this function is below all of them
+static void __attribute__((noinline, noreturn)) RestorePages(size_t off) {
+   choice_t*  C = CHOICE(off);
+   size_t     t;
+   /// The most recent first; above StackBottom the stack is not restored
+   while ( tused > C->pages ) {
+      tused--;
+      if ( STACK_PAGE(tpage[tused]) ) {
+         reopen(tpage[tused]);
+         t = StackBottom + 1 - tpage[tused];
+         memcpy(tpage[tused], tdata + tused*pagesize, t < pagesize ? t : pagesize);
+      }
+   }
+   memcpy(C->low, A + off + sizeof(choice_t), C->stack);
+   protect();
+   longjmp(C->env, 1);
+}
+
+/// Move the stack pointer below the pages to restore, and below the page
+/// of this frame, which may be one of them: a fault from here on is on a
+/// page that RestorePages restores, or on the pages opened below them
+static void __attribute__((noinline, noreturn)) RestoreStack(size_t off) {
+   choice_t*      C = CHOICE(off);
+   volatile char  here;
+   char*          low = (char*)((uintptr_t)&here & ~(uintptr_t)(pagesize-1)) - pagesize;
+   char*          p;
+   size_t         t;
+   if ( C->low < low )
+      low = (char*)((uintptr_t)C->low & ~(uintptr_t)(pagesize-1));
+   for ( t = C->pages; t < tused; t++ )
+      if ( STACK_PAGE(tpage[t]) && tpage[t] < low )
+         low = tpage[t];
+   for ( p = low - 3*pagesize; p < low; p += pagesize )
+      if ( p >= sprot && p < stop )
+         reopen(p);
+   if ( (uintptr_t)&here + 1024 > (uintptr_t)low ) {
+      volatile char* pad = (volatile char*) alloca((uintptr_t)&here + 1024 - (uintptr_t)low);
+      pad[0] = 0;
+   }
+   RestorePages(off);
+}
+
+unsigned int Choice(const int N) {
+   size_t off;
+   if ( N <= 0 )
+      Backtrack();
+   if ( N == 1 )
+      return 1;
+   if ( job != NULL && level < split )
+      return Split(N);
+   used = (used + 15) & ~(size_t)15;
+   off = grow(sizeof(choice_t));
+   CHOICE(off)->n = N;
+   CHOICE(off)->next = 2;
+   CHOICE(off)->nareas = nareas;
+   CHOICE(off)->level = level++;
+   CHOICE(off)->prev = top;
+   CHOICE(off)->pages = tused;
+   top = off;
+   if ( setjmp(CHOICE(off)->env) != 0 )
+      return Resume();
+   SaveState(off);
+   protect();
+   return 1;
+}
+
+void Backtrack(void) {
+   choice_t*  C;
+   size_t     p, t;
+   int        i;
+   if ( top == NONE ) {
+      if ( job != NULL )   /// End of the job of a worker
+         longjmp(finished, 1);
+      if ( Fiasco != NULL )
+         Fiasco();
+      exit(EXIT_SUCCESS);
+   }
+   C = CHOICE(top);
+   /// The pages of the areas written after the choice point, the most recent
+   /// first (the stack pages are restored by RestoreStack)
+   for ( t = tused; t > C->pages; t-- ) {
+      if ( tpage[t-1] == NULL || STACK_PAGE(tpage[t-1]) )   /// Removed area, or stack
+         continue;
+      mprotect(tpage[t-1], pagesize, PROT_READ | PROT_WRITE);
+      memcpy(tpage[t-1], tdata + (t-1)*pagesize, pagesize);
+      writable = 1;
+   }
+   /// The areas notified after the choice point are dropped
+   while ( nareas > C->nareas )
+      RemoveNotification(areas[nareas-1].base);
+   p = top + sizeof(choice_t) + C->stack;
+   for ( i = 0; i < nareas; i++ ) {
+      area_t* a = &areas[i];
+      memcpy(a->base, A + p, a->lo - a->base);
+      p += a->lo - a->base;
+      memcpy(a->hi, A + p, a->base + a->size - a->hi);
+      p += a->base + a->size - a->hi;
+   }
+   RestoreStack(top);
+}
+
+void Cut(void) {
+   if ( top != NONE ) {
+      used = top;
+      top = CHOICE(top)->prev;
+   }
+}
+
+void ClearChoices(void) {
+   used = 0;
+   top = NONE;
+   tused = 0;
+   unprotect_stack();
+   stop = sprot = smin = NULL;
+}
+
+void* NotifyStorage(void* Base, size_t Size) {
+   area_t* a;
+   if ( Base == NULL )
+      return NULL;
+   if ( pagesize == 0 )
+      pagesize = sysconf(_SC_PAGESIZE);
+   if ( nareas == maxareas ) {
+      maxareas = 2*maxareas + 8;
+      areas = (area_t*) realloc(areas, maxareas*sizeof(area_t));
+      if ( areas == NULL )
+         fail("out of memory");
+   }
+   a = &areas[nareas++];
+   a->base = (char*)Base;
+   a->size = Size;
+   a->lo = (char*)(((uintptr_t)Base + pagesize-1) & ~(uintptr_t)(pagesize-1));
+   a->hi = (char*)(((uintptr_t)Base + Size) & ~(uintptr_t)(pagesize-1));
+   if ( Size < COW_MIN || a->hi <= a->lo )
+      a->lo = a->hi = a->base + Size;
+   else {
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      pthread_once(&once, install);
+      writable = 1;
+   }
+   return Base;
+}
+
+void RemoveNotification(void* Base) {
+   size_t t;
+   int    i;
+   for ( i = nareas-1; i >= 0 && areas[i].base != (char*)Base; i-- )
+      ;
+   if ( i < 0 )
+      return;
+   if ( areas[i].lo < areas[i].hi ) {
+      mprotect(areas[i].lo, areas[i].hi - areas[i].lo, PROT_READ | PROT_WRITE);
+      for ( t = 0; t < tused; t++ )
+         if ( tpage[t] >= areas[i].lo && tpage[t] < areas[i].hi )
+            tpage[t] = NULL;
+   }
+   memmove(&areas[i], &areas[i+1], (nareas-i-1)*sizeof(area_t));
+   nareas--;
+}
+
+void ClearNotifications(void) {
+   while ( nareas > 0 )
+      RemoveNotification(areas[nareas-1].base);
+}
+
+void* NotifyAlloc(size_t Size) {
+   void* p = NULL;
+   if ( pagesize == 0 )
+      pagesize = sysconf(_SC_PAGESIZE);
+   if ( Size < COW_MIN )
+      p = malloc(Size);
+   else if ( posix_memalign(&p, pagesize, (Size + pagesize-1) & ~(pagesize-1)) != 0 )
+      return NULL;
+   if ( job != NULL && p != NULL ) {   /// Freed at the end of the job
+      if ( nallocs == maxallocs ) {
+         maxallocs = 2*maxallocs + 8;
+         allocs = (void**) realloc(allocs, maxallocs*sizeof(void*));
+         if ( allocs == NULL )
+            fail("out of memory");
+      }
+      allocs[nallocs++] = p;
+   }
+   return p;
+}
+
+static void forget(void* P) {
+   int i;
+   for ( i = nallocs-1; i >= 0; i-- )
+      if ( allocs[i] == P ) {
+         allocs[i] = allocs[--nallocs];
+         return;
+      }
+}
+
+void* NotifyAllocZero(size_t Size) {
+   void* p = NotifyAlloc(Size);
+   if ( p != NULL )
+      memset(p, 0, Size);
+   return p;
+}
+
+void* NotifyRealloc(void* P, size_t Size) {
+   size_t old = 0;
+   void*  q;
+   int    i;
+   for ( i = 0; i < nareas; i++ )
+      if ( areas[i].base == (char*)P )
+         old = areas[i].size;
+   RemoveNotification(P);
+   q = NotifyAlloc(Size);
+   if ( q != NULL && P != NULL )
+      memcpy(q, P, old < Size ? old : Size);
+   forget(P);
+   free(P);
+   return NotifyStorage(q, Size);
+}
+
+void NotifyFree(void* P) {
+   RemoveNotification(P);
+   forget(P);
+   free(P);
+}
+
+/// A write from user space to every page of the range: the protected ones
+/// fault here, and go on the trail as on any other first write
+void NotifyTouch(void* P, size_t Size) {
+   volatile char* p = (volatile char*)P;
+   volatile char* end = p + Size;
+   if ( pagesize == 0 )
+      return;
+   while ( p < end ) {
+      *p = *p;
+      p = (volatile char*)(((uintptr_t)p | (pagesize-1)) + 1);
+   }
+}
+
+/// Parallel mode
+
+static void* worker(void* arg) {
+   job_t* volatile J;
+   int             k;
+   me = (int)(long)arg;
+   path = (int*) malloc((split+1)*sizeof(int));
+   for ( ;; ) {
+      /// Own jobs first, then steal from the others
+      J = pop(&deques[me], 0);
+      for ( k = 1; J == NULL && k < nworkers; k++ )
+         J = pop(&deques[(me+k) % nworkers], 1);
+      if ( J == NULL ) {
+         if ( __atomic_load_n(&pending, __ATOMIC_ACQUIRE) == 0 )
+            break;
+         sched_yield();
+         continue;
+      }
+      job = J;
+      level = 0;
+      if ( setjmp(finished) == 0 )
+         Backtracking(model());
+      /// The job is over: its choice points, notifications and storage go
+      ClearChoices();
+      ClearNotifications();
+      while ( nallocs > 0 )
+         free(allocs[--nallocs]);
+      job = NULL;
+      free(J);
+      __atomic_sub_fetch(&pending, 1, __ATOMIC_ACQ_REL);
+   }
+   if ( altstack != NULL ) {
+      stack_t ss;
+      ss.ss_sp = NULL;
+      ss.ss_size = 0;
+      ss.ss_flags = SS_DISABLE;
+      sigaltstack(&ss, NULL);
+      free(altstack);
+      altstack = NULL;
+   }
+   free(path);
+   free(allocs);
+   free(A);
+   if ( tcap > 0 ) {
+      munmap(tpage, tcap*sizeof(char*));
+      munmap(tdata, tcap*pagesize);
+   }
+   free(areas);
+   allocs = NULL;
+   A = NULL;
+   tpage = NULL;
+   tdata = NULL;
+   areas = NULL;
+   used = cap = tcap = 0;
+   maxareas = maxallocs = 0;
+   return NULL;
+}
+
+void ParallelBacktracking(void (*Model)(void), int Threads, int Depth) {
+   pthread_t* tid;
+   job_t*     root;
+   int        i;
+   if ( Threads < 1 )
+      Threads = 1;
+   if ( pagesize == 0 )
+      pagesize = sysconf(_SC_PAGESIZE);
+   model = Model;
+   split = Depth < 0 ? 0 : Depth;
+   nworkers = Threads;
+   deques = (deque_t*) calloc(Threads, sizeof(deque_t));
+   tid = (pthread_t*) malloc(Threads*sizeof(pthread_t));
+   for ( i = 0; i < Threads; i++ )
+      pthread_mutex_init(&deques[i].lock, NULL);
+   root = (job_t*) calloc(1, sizeof(job_t));
+   push(&deques[0], root);
+   for ( i = 0; i < Threads; i++ )
+      pthread_create(&tid[i], NULL, worker, (void*)(long)i);
+   for ( i = 0; i < Threads; i++ )
+      pthread_join(tid[i], NULL);
+   for ( i = 0; i < Threads; i++ ) {
+      pthread_mutex_destroy(&deques[i].lock);
+      free(deques[i].job);
+   }
+   free(deques);
+   free(tid);
+   deques = NULL;
+   if ( Fiasco != NULL )
+      Fiasco();
+}
+
+/// Shared bounds: few of them, registered before the parallel search
+#define MAX_SHARED  16
+
+static struct {
+   int*  bound;
+   int (*merge)(int, int);
+} shared[MAX_SHARED];
+static int              nshared = 0;
+static pthread_mutex_t  exclusive = PTHREAD_MUTEX_INITIALIZER;
+
+void Share(int* Bound, int (*Merge)(int Old, int New)) {
+   if ( nshared == MAX_SHARED )
+      fail("too many shared bounds");
+   shared[nshared].bound = Bound;
+   shared[nshared].merge = Merge;
+   nshared++;
+}
+
+int Improve(int* Bound, int Value) {
+   int (*merge)(int, int) = NULL;
+   int i, old, m;
+   for ( i = 0; i < nshared; i++ )
+      if ( shared[i].bound == Bound )
+         merge = shared[i].merge;
+   old = __atomic_load_n(Bound, __ATOMIC_ACQUIRE);
+   do {
+      m = (merge != NULL) ? merge(old, Value) : Value;
+      if ( m == old )
+         return 0;
+   } while ( !__atomic_compare_exchange_n(Bound, &old, m, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) );
+   return 1;
+}
+
+void EnterExclusive(void) {
+   pthread_mutex_lock(&exclusive);
+}
+
+void LeaveExclusive(void) {
+   pthread_mutex_unlock(&exclusive);
+}
@@ -0,0 +1,119 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Drop-in replacement of CBack (K. Helsgaun, "CBack: A Simple Tool for
+ *  Backtrack Programming in C"), with the same API: programs written for
+ *  CBack compile unmodified with -I pointing to this directory, but for the
+ *  system calls that write into notified storage (see NotifyTouch).
+ *
+ *  As in CBack, Choice(N) saves the segment of the C stack between the call
+ *  and StackBottom, so that the local variables are restored on Backtrack.
+ *  The differences are in the costs of a choice point:
+ *   - all the saved state lives in one LIFO arena, reused across choice
+ *     points: no malloc/free at each Choice, and the memory touched by a
+ *     backtrack is the most recently written one;
+ *   - the notified storage (Notify, Nmalloc, Ncalloc, ...) is restored by
+ *     a trail: small areas are copied at each Choice, while the pages of
+ *     the large ones are write protected, and a page is copied to the trail
+ *     only the first time it is written after a choice point (copy on
+ *     write);
+ *   - a long stack segment (at least STACK_COW_MIN bytes) is trailed in the
+ *     same way, but for the page of the Choice frame, which is copied: a
+ *     deep recursion pays for the pages it writes, not for its depth. A
+ *     short segment is copied, as in CBack, since a page fault costs more
+ *     than copying a few pages.
+ *  Global variables that are not notified keep their values on backtrack,
+ *  as in CBack.
+ *
+ *  ParallelBacktracking(Model, Threads, Depth) runs the same model over a
+ *  pool of threads: the first Depth choices (with N > 1) of the model are
+ *  split into jobs, which are searched sequentially by the workers and
+ *  stolen by the idle ones. A worker starts a job by running Model again,
+ *  replaying the choices of the job, so in the parallel mode:
+ *   - the number of alternatives of the first Depth choices must depend
+ *     only on the previous choices (not on the bounds found so far);
+ *   - the state of the search must be local, or allocated by the model
+ *     with Nmalloc/Ncalloc (freed at the end of each job): Notify on a
+ *     global variable would restore it under the feet of the other threads;
+ *   - the bounds shared by the threads are registered with Share(&LB, Merge),
+ *     and updated with Improve(&LB, Value), i.e. LB = Merge(LB, Value) with a
+ *     compare and swap; anything else shared (e.g. the best solution) is
+ *     written inside Exclusive(...).
+ *  Fiasco is called once, when all the jobs are over, and then
+ *  ParallelBacktracking returns.
+ */
+
+#ifndef _CBACK_H_
+#define _CBACK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define Backtracking(S)    { char Dummy; StackBottom = &Dummy; S; }
+
+#define Notify(V)          NotifyStorage(&(V), sizeof(V))
+#define Nmalloc(Size)      NotifyStorage(NotifyAlloc(Size), Size)
+#define Ncalloc(N, Size)   NotifyStorage(NotifyAllocZero((size_t)(N)*(Size)), (size_t)(N)*(Size))
+#define Nrealloc(P, Size)  NotifyRealloc(P, Size)
+#define Nfree(P)           NotifyFree(P)
+#define NTouch(P, Size)    NotifyTouch(P, Size)
+#define ClearAll()         (ClearChoices(), ClearNotifications())
+#define Exclusive(S)       { EnterExclusive(); S; LeaveExclusive(); }
+
+/// This runtime has the parallel mode
+#define CBACK_PARALLEL
+
+/// Returns 1, and then 2, ..., N on the following backtracks to this call
+unsigned int Choice(const int N);
+
+/// Back to the most recent Choice that has not returned all its values:
+/// if there is none, Fiasco is called (if not NULL) and the program exits
+void Backtrack(void);
+
+/// Remove the most recent choice point, or all of them
+void Cut(void);
+void ClearChoices(void);
+
+/// Storage restored on backtrack. An area must not be removed (or freed)
+/// while a choice point made after its notification is alive
+void* NotifyStorage(void* Base, size_t Size);
+void  RemoveNotification(void* Base);
+void  ClearNotifications(void);
+
+/// Allocation of notified storage: large areas are page aligned, so that
+/// all of their pages can be trailed on write
+void* NotifyAlloc(size_t Size);
+void* NotifyAllocZero(size_t Size);
+void* NotifyRealloc(void* P, size_t Size);
+void  NotifyFree(void* P);
+
+/// The protected pages are trailed by the fault of the first write, which
+/// the kernel does not raise: a system call writing into notified storage,
+/// or into a buffer on a trailed stack segment (e.g. read() into Ncalloc
+/// storage), fails with EFAULT. NTouch(P, Size) trails the pages of the
+/// range and leaves them writable until the next Choice or Backtrack, so it
+/// goes right before the call. CBack programs that pass such buffers to the
+/// kernel need it; the ones that only write them from C do not
+void  NotifyTouch(void* P, size_t Size);
+
+/// Parallel mode
+void ParallelBacktracking(void (*Model)(void), int Threads, int Depth);
+void Share(int* Bound, int (*Merge)(int Old, int New));
+int  Improve(int* Bound, int Value);   /// 1 if Value changed the bound
+void EnterExclusive(void);
+void LeaveExclusive(void);
+
+extern void (*Fiasco)();
+extern __thread char* StackBottom;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CBACK_H_ */
@@ -14,6 +14,9 @@ using std::numeric_limits;
 #include <vector>
 using std::vector;
 
+#include <pthread.h>
+#include <sys/resource.h>
+
 #include <gecode/driver.hh>
 
 
@@ -25,26 +28,93 @@ extern "C" {
 #include "reorder.h"
 }
 
+/// Bit-parallel maximum clique solver (C library)
+#include "maxclique.h"
+/// DSATUR and TabuCol upper bounds (C library)
+#include "tabucol.h"
+/// Column generation lower bound (C library)
+#include "colgen.h"
+/// Enumeration of the maximal cliques (C library)
+#include "bkclique.h"
+
 using namespace Gecode;
 using namespace Gecode::Int;
 
 int    BRANCH   = 7;      /// Type of branching rule
 double SCALE    = 14;     /// Scale factor on the geometric restart policy
-int    PROP     = 1;      /// Type of propagation (Domain, Bound, only arcs)
+int    PROP     = 1;      /// Type of propagation (Domain, Bound, only arcs, global)
 int    UB0      = -1;     /// To provide "manually" an initial upper bound
 int    NOGOOD   = 0;      /// Depth limit in the generation of nogood
+long   LS_ITER  = 100000; /// TabuCol iterations for each number of colors
+int    STATS    = 0;      /// Interval of the "progress" lines in ms (0 for none)
+double CG_TIME  = 60;     /// Time limit of the column generation in s (0 for none)
 set_t  C        = NULL;   /// Maximal (best) clique found in preprocessing
 
 
+/// Peak resident memory of the process, in KB
+long peakMemory ( void ) {
+   struct rusage ru;
+   getrusage(RUSAGE_SELF, &ru);
+   return ru.ru_maxrss;
+}
+
+/// Statistics of a search as one JSON line, after the text output: 'time'
+/// is the time since the CP model started and 'step' the time spent on the
+/// current upper bound, in seconds. 'status' is 1 once UB is proved optimal
+void printStats ( const char* event, int branch, int UB, int status, 
+      double time, double step, const Search::Statistics& s ) {
+   fprintf(stdout, "{\"event\":\"%s\",\"branch\":%d,\"ub\":%d,\"status\":%d,"
+         "\"time\":%.3f,\"step\":%.3f,\"node\":%lu,\"fail\":%lu,\"propagate\":%lu,"
+         "\"restart\":%lu,\"nogood\":%lu,\"depth\":%lu,\"memory\":%ld}\n",
+         event, branch, UB, status, time, step, s.node, s.fail, s.propagate, 
+         s.restart, s.nogood, s.depth, peakMemory());
+   fflush(stdout);
+}
+
+/// Base of the stop objects: every STATS ms it writes a "progress" line with
+/// the statistics of the engine, which calls stop() at every node. 'UB' is
+/// the best coloring known when the search starts, and 't0' the time of the
+/// CP model at that point
+class ProgressStop : public Search::Stop {
+   private:
+      Support::Timer    t;
+      pthread_mutex_t   lock;    /// Parallel engines call stop() from every worker
+      double            next;
+      double            t0;
+      int               branch;
+      int               UB;
+   protected:
+      ProgressStop(double t00, int branch0, int UB0)
+         : next(STATS), t0(t00), branch(branch0), UB(UB0) {
+         t.start();
+         pthread_mutex_init(&lock, NULL);
+      }
+      void progress(const Search::Statistics& s) {
+         if ( STATS > 0 && pthread_mutex_trylock(&lock) == 0 ) {
+            double e = t.stop();
+            if ( e >= next ) {
+               printStats("progress", branch, UB, 0, t0+e/1000, e/1000, s);
+               next = e + STATS;
+            }
+            pthread_mutex_unlock(&lock);
+         }
+      }
+   public:
+      ~ProgressStop(void) {
+         pthread_mutex_destroy(&lock);
+      }
+};
+
 /// Cutoff object for the script
-class MyCutoff : public Search::Stop {
+class MyCutoff : public ProgressStop {
    private:
       Search::TimeStop*    ts; 
 
-      MyCutoff(int time)
-         : ts((time > 0) ? new Search::TimeStop(time) : NULL) {}
+      MyCutoff(int time, double t0, int UB)
+         : ProgressStop(t0, BRANCH, UB), ts((time > 0) ? new Search::TimeStop(time) : NULL) {}
    public:
       virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+         progress(s);
          return
             ((ts != NULL) && ts->stop(s,o));
       }
@@ -53,17 +123,309 @@ class MyCutoff : public Search::Stop {
             ((ts != NULL) && ts->stop(s,o));
       }
       static Search::Stop*
-         create(int time) {
-            if (time == 0)
+         create(int time, double t0 = 0, int UB = 0) {
+            if (time == 0 && STATS == 0)
                return NULL;
             else
-               return new MyCutoff(time);
+               return new MyCutoff(time, t0, UB);
          }
       ~MyCutoff(void) {
          delete ts;
       }
 };
 
+/// State shared by the threads of the portfolio mode
+struct Portfolio {
+   pthread_mutex_t  lock;
+   volatile int     UB;           /// Best upper bound found by any thread
+   volatile bool    optimal;      /// Some thread proved that UB is optimal
+   int              LB;           /// Lower bound: UB is optimal if it reaches it
+   vector<int>      certificate;  /// Coloring of value UB
+};
+
+/// Stop object of a portfolio thread: on time out, when another thread
+/// proves optimality, or when another thread finds a coloring at least as
+/// good as the one searched by this thread (with 'target' colors)
+class PortfolioStop : public ProgressStop {
+   private:
+      Search::TimeStop*    ts; 
+      const Portfolio*     P;
+      int                  target;
+   public:
+      PortfolioStop(int time, const Portfolio* P0, int target0, double t0, int branch)
+         : ProgressStop(t0, branch, target0+1), 
+           ts((time > 0) ? new Search::TimeStop(time) : NULL), P(P0), target(target0) {}
+      virtual bool stop(const Search::Statistics& s, const Search::Options& o) {
+         progress(s);
+         return
+            ((ts != NULL) && ts->stop(s,o)) || P->optimal || P->UB <= target;
+      }
+      bool stopTime(const Search::Statistics& s, const Search::Options& o) {
+         return
+            ((ts != NULL) && ts->stop(s,o));
+      }
+      ~PortfolioStop(void) {
+         delete ts;
+      }
+};
+
+
+/// Collection of cliques stored in one contiguous arena: clique i has the
+/// vertices vertex[start[i]..start[i+1]), in increasing order. A clique is
+/// stored only once: add() looks it up in an open addressing hash table.
+/// After index(), the cliques of vertex v (with two vertices at least) are
+/// incident(v)[0..degree(v))
+class CliqueCover {
+   private:
+      vector<int>       start;
+      vector<int>       vertex;
+      vector<int>       table;   /// Clique index+1, or 0 if the slot is empty
+      vector<int>       vstart;  /// Cliques of each vertex, in the same layout
+      vector<int>       vclique;
+
+      static unsigned int hash ( const int* v, int k ) {
+         unsigned int h = 2166136261U;   /// FNV-1a
+         for ( int i = 0; i < k; ++i ) {
+            h ^= (unsigned int)v[i];
+            h *= 16777619U;
+         }
+         return h;
+      }
+      bool equal ( int i, const int* v, int k ) const {
+         if ( size(i) != k )
+            return false;
+         for ( int j = 0; j < k; ++j )
+            if ( vertex[start[i]+j] != v[j] )
+               return false;
+         return true;
+      }
+      void rehash ( void ) {
+         vector<int> old(2*table.size() > 0 ? 2*table.size() : 64, 0);
+         table.swap(old);
+         int mask = table.size()-1;
+         for ( int i = 0; i < count(); ++i ) {
+            unsigned int h = hash(&vertex[start[i]], size(i)) & mask;
+            while ( table[h] != 0 )
+               h = (h+1) & mask;
+            table[h] = i+1;
+         }
+      }
+   public:
+      CliqueCover ( void ) : start(1,0) { rehash(); }
+
+      int count ( void ) const { return start.size()-1; }
+      int size ( int i ) const { return start[i+1]-start[i]; }
+      const int* operator[] ( int i ) const { return &vertex[start[i]]; }
+
+      /// Add the clique 's': return false if it is already stored
+      bool add ( set_t s ) {
+         int k = start.back();
+         for ( int j = set_return_next(s, -1); j >= 0; j = set_return_next(s, j) )
+            vertex.push_back(j);
+         int len = vertex.size()-k;
+         int mask = table.size()-1;
+         unsigned int h = hash(&vertex[k], len) & mask;
+         for ( ; table[h] != 0; h = (h+1) & mask )
+            if ( equal(table[h]-1, &vertex[k], len) ) {
+               vertex.resize(k);
+               return false;
+            }
+         table[h] = count()+1;
+         start.push_back(vertex.size());
+         if ( 2*count() > (int)table.size() )
+            rehash();
+         return true;
+      }
+
+      /// Index the cliques of each of the 'n' vertices
+      void index ( int n ) {
+         vstart.assign(n+1, 0);
+         for ( int i = 0; i < count(); ++i )
+            if ( size(i) > 1 )
+               for ( int j = start[i]; j < start[i+1]; ++j )
+                  vstart[vertex[j]+1]++;
+         for ( int v = 0; v < n; ++v )
+            vstart[v+1] += vstart[v];
+         vclique.resize(vstart[n]);
+         vector<int> pos(vstart.begin(), vstart.end()-1);
+         for ( int i = 0; i < count(); ++i )
+            if ( size(i) > 1 )
+               for ( int j = start[i]; j < start[i+1]; ++j )
+                  vclique[pos[vertex[j]]++] = i;
+      }
+      int degree ( int v ) const { return vstart[v+1]-vstart[v]; }
+      const int* incident ( int v ) const { return &vclique[vstart[v]]; }
+};
+
+/// Global coloring propagator: x[i] != x[j] for every edge of 'g', and one
+/// "distinct" for every clique of the cover. It replaces the propagators of
+/// the cliques and of the edges (millions on dense graphs) with a single one,
+/// which wakes up only when a vertex is colored. The vertices whose color
+/// has already been removed from the neighbours are kept in the bitset
+/// 'done', the only state copied on cloning. Then, for each clique of the
+/// newly colored vertices, the Hall condition on the uncolored ones: if the
+/// union of their domains has fewer colors than vertices the space fails,
+/// and if it has as many colors, a color in a single domain is assigned
+class ColoringPropagator : public Propagator {
+   protected:
+      ViewArray<Int::IntView>   x;
+      const graph_t*            g;
+      const CliqueCover*        Cs;
+      word_t*                   done;
+
+      /// Colors of the views, which are at most x[0].max()+1 at posting
+      int                       k;
+
+      ColoringPropagator ( Home home, ViewArray<Int::IntView>& x0, 
+            const graph_t* g0, const CliqueCover* Cs0 )
+         : Propagator(home), x(x0), g(g0), Cs(Cs0), k(0) {
+         int w = BS_WORDS(x.size());
+         done = home.alloc<word_t>(w);
+         bs_clear(done, w);
+         for ( int i = 0; i < x.size(); ++i )
+            k = std::max(k, x[i].max()+1);
+         x.subscribe(home, *this, Int::PC_INT_VAL);
+      }
+
+      ColoringPropagator ( Space& home, bool share, ColoringPropagator& p )
+         : Propagator(home, share, p), g(p.g), Cs(p.Cs), k(p.k) {
+         int w = BS_WORDS(p.x.size());
+         x.update(home, share, p.x);
+         done = home.alloc<word_t>(w);
+         bs_copy(done, p.done, w);
+      }
+
+      /// Hall condition on the uncolored vertices of clique 'c', without the
+      /// colors of the colored ones (after the peeling, the vertices of a
+      /// clique may be no longer adjacent in 'g'): the vertices colored here
+      /// are appended to queue[0..qn)
+      ExecStatus hall ( Space& home, int c, int* cnt, int* who, int* vals, 
+            int* queue, int& qn ) {
+         const int* v = (*Cs)[c];
+         int nfree = 0, nval = 0, nused;
+         ExecStatus es = ES_OK;
+         for ( int j = 0; j < Cs->size(c); ++j )
+            if ( x[v[j]].assigned() ) {
+               int a = x[v[j]].val();
+               if ( cnt[a] < 0 ) {
+                  es = ES_FAILED;
+                  continue;
+               }
+               cnt[a] = -1;
+               vals[nval++] = a;
+            }
+         nused = nval;
+         for ( int j = 0; j < Cs->size(c); ++j ) {
+            if ( x[v[j]].assigned() )
+               continue;
+            nfree++;
+            for ( Int::ViewValues<Int::IntView> it(x[v[j]]); it(); ++it ) {
+               if ( cnt[it.val()] < 0 )
+                  continue;
+               if ( cnt[it.val()]++ == 0 )
+                  vals[nval++] = it.val();
+               who[it.val()] = v[j];
+            }
+         }
+         if ( es == ES_OK && nval-nused < nfree )
+            es = ES_FAILED;
+         else if ( es == ES_OK && nval-nused == nfree )
+            for ( int l = nused; l < nval && es == ES_OK; ++l ) {
+               int i = who[vals[l]];
+               if ( cnt[vals[l]] == 1 && !x[i].assigned() ) {
+                  if ( me_failed(x[i].eq(home, vals[l])) )
+                     es = ES_FAILED;
+                  else {
+                     BS_ADD(done, i);
+                     queue[qn++] = i;
+                  }
+               }
+            }
+         for ( int l = 0; l < nval; ++l )
+            cnt[vals[l]] = 0;
+         return es;
+      }
+
+   public:
+      virtual Propagator* copy ( Space& home, bool share ) {
+         return new (home) ColoringPropagator(home, share, *this);
+      }
+
+      virtual PropCost cost ( const Space&, const ModEventDelta& ) const {
+         return PropCost::linear(PropCost::HI, x.size());
+      }
+
+      virtual ExecStatus propagate ( Space& home, const ModEventDelta& ) {
+         int n = x.size();
+         Region r(home);
+         int* queue = r.alloc<int>(n);
+         int* cnt   = r.alloc<int>(k);
+         int* who   = r.alloc<int>(k);
+         int* vals  = r.alloc<int>(k);
+         int  qn = 0, q = 0, h = 0;
+         for ( int l = 0; l < k; ++l )
+            cnt[l] = 0;
+         for ( int i = 0; i < n; ++i )
+            if ( !BS_CONTAINS(done, i) && x[i].assigned() ) {
+               BS_ADD(done, i);
+               queue[qn++] = i;
+            }
+         while ( q < qn ) {
+            /// Remove the new colors from the neighbours
+            for ( ; q < qn; ++q ) {
+               int i = queue[q];
+               int c = x[i].val();
+               for ( int j = set_return_next(g->edges[i], -1); j >= 0; j = set_return_next(g->edges[i], j) ) {
+                  if ( BS_CONTAINS(done, j) ) {
+                     if ( x[j].val() == c )
+                        return ES_FAILED;
+                     continue;
+                  }
+                  ModEvent me = x[j].nq(home, c);
+                  if ( me_failed(me) )
+                     return ES_FAILED;
+                  if ( me == Int::ME_INT_VAL ) {
+                     BS_ADD(done, j);
+                     queue[qn++] = j;
+                  }
+               }
+            }
+            /// Hall condition on the cliques of the vertices colored so far
+            for ( ; h < qn; ++h )
+               for ( int l = 0; l < Cs->degree(queue[h]); ++l )
+                  GECODE_ES_CHECK(hall(home, Cs->incident(queue[h])[l], cnt, who, vals, queue, qn));
+         }
+         if ( qn > 0 ) {
+            bool all = true;
+            for ( int i = 0; i < n && all; ++i )
+               all = BS_CONTAINS(done, i);
+            if ( all )
+               return home.ES_SUBSUMED(*this);
+         }
+         return ES_FIX;
+      }
+
+      virtual size_t dispose ( Space& home ) {
+         x.cancel(home, *this, Int::PC_INT_VAL);
+         (void) Propagator::dispose(home);
+         return sizeof(*this);
+      }
+
+      static ExecStatus post ( Home home, ViewArray<Int::IntView>& x, 
+            const graph_t* g, const CliqueCover* Cs ) {
+         (void) new (home) ColoringPropagator(home, x, g, Cs);
+         return ES_OK;
+      }
+};
+
+/// Post the coloring propagator on the vertices 'x' of 'g' (the cliques of
+/// 'Cs' must be indexed)
+void coloring ( Home home, const IntVarArgs& x, const graph_t* g, const CliqueCover& Cs ) {
+   if ( home.failed() )
+      return;
+   ViewArray<Int::IntView> y(home, x);
+   GECODE_ES_FAIL(ColoringPropagator::post(home, y, g, &Cs));
+}
 
 static double trampoline(const Space& home, IntVar x, int i); 
 
@@ -72,11 +434,14 @@ class GraphColoring : public Script {
    protected:
       /// Mapping vertices to colors
       IntVarArray   x;  
+      /// Where to keep the master space with the no-goods (see keepMaster)
+      GraphColoring** keep;
    public:
       /// Actual model
       GraphColoring( const graph_t*  g, int k, 
-            int n_c, const set_t* Cs, const vector<int>& init ) 
-         :  x ( *this, g->n, 0, k-1 )     /// Colors start from '1'                  
+            const CliqueCover& Cs, const vector<int>& init, int rule = BRANCH ) 
+         :  x ( *this, g->n, 0, k-1 ),    /// Colors start from '1'                  
+            keep ( NULL )
       { 
          int n = g->n;
          if ( !init.empty() ) {
@@ -84,21 +449,23 @@ class GraphColoring : public Script {
             for ( int i = 0; i < n; ++i )
                if ( init[i] > 0 ) 
                   rel ( *this, x[i], IRT_EQ, init[i]);
-            for ( int i = 0; i < n-1; ++i ) 
-               for ( int j = i+1; j < n ; ++j )
-                  if ( GRAPH_IS_EDGE(g,i,j) )
-                     rel ( *this, x[i], IRT_NQ, x[j]);
+            if ( PROP != 3 )
+               for ( int i = 0; i < n-1; ++i ) 
+                  for ( int j = i+1; j < n ; ++j )
+                     if ( GRAPH_IS_EDGE(g,i,j) )
+                        rel ( *this, x[i], IRT_NQ, x[j]);
          }
 
 
-         /// Post an 'alldifferent' constraints for each maximal cliques
-         for ( int i = 0; i < n_c; ++i )
-            if ( set_size(Cs[i]) > 1 ) {
-               IntVarArgs xdiff( set_size(Cs[i]) );
-               int idx = 0;
-               for ( int j = 0; j < n; ++j ) 
-                  if ( SET_CONTAINS_FAST(Cs[i],j) )
-                     xdiff[idx++] = x[j];
+         /// Post an 'alldifferent' constraints for each maximal cliques, or
+         /// the coloring propagator for all the edges and cliques
+         if ( PROP == 3 )
+            coloring ( *this, x, g, Cs );
+         for ( int i = 0; i < Cs.count() && PROP != 3; ++i )
+            if ( Cs.size(i) > 1 ) {
+               IntVarArgs xdiff( Cs.size(i) );
+               for ( int j = 0; j < Cs.size(i); ++j ) 
+                  xdiff[j] = x[Cs[i][j]];
                if ( PROP == 0 )
                   distinct ( *this, xdiff, ICL_BND );
                if ( PROP == 1 )
@@ -114,23 +481,23 @@ class GraphColoring : public Script {
          Symmetries syms;
          syms << ValueSymmetry(IntArgs::create(k,0));
          Rnd r(13U*k);
-         if ( BRANCH == 0 ) 
+         if ( rule == 0 ) 
             branch(*this, x, tiebreak(INT_VAR_SIZE_MIN(), INT_VAR_RND(r)), INT_VAL_MIN());
-         if ( BRANCH == 1 ) 
+         if ( rule == 1 ) 
             branch(*this, x, tiebreak(INT_VAR_SIZE_MIN(), INT_VAR_RND(r)), INT_VAL_MIN(), syms);
-         if ( BRANCH == 2 ) 
+         if ( rule == 2 ) 
             branch(*this, x, tiebreak(INT_VAR_AFC_MAX(), INT_VAR_RND(r)), INT_VAL_MIN(), syms);
-         if ( BRANCH == 3 ) 
+         if ( rule == 3 ) 
             branch(*this, x, tiebreak(INT_VAR_ACTIVITY_MAX(), INT_VAR_RND(r)), INT_VAL_MIN(), syms);
-         if ( BRANCH == 4 ) 
+         if ( rule == 4 ) 
             branch(*this, x, tiebreak(INT_VAR_ACTIVITY_SIZE_MAX(), INT_VAR_RND(r)), INT_VAL_MIN(), syms);
-         if ( BRANCH == 5 ) 
+         if ( rule == 5 ) 
             branch(*this, x, tiebreak(INT_VAR_DEGREE_SIZE_MAX(), INT_VAR_RND(r)), INT_VAL_MIN(), syms);
-         if ( BRANCH == 6 ) 
+         if ( rule == 6 ) 
             branch(*this, x, tiebreak(INT_VAR_MERIT_MAX(&trampoline), INT_VAR_RND(r)), INT_VAL_MIN(), syms );
-         if ( BRANCH == 7 ) 
+         if ( rule == 7 ) 
             branch(*this, x, tiebreak(INT_VAR_AFC_SIZE_MAX(), INT_VAR_RND(r)), INT_VAL_MIN(), syms );
-         if ( BRANCH == 8 ) {
+         if ( rule == 8 ) {
             int col = 0;
             for ( int i = 0; i < n; i++ )
                if ( SET_CONTAINS_FAST(C, i) )
@@ -139,10 +506,46 @@ class GraphColoring : public Script {
          }
       }
 
-      GraphColoring( bool share, GraphColoring& s) : Script(share,s) {
+      GraphColoring( bool share, GraphColoring& s) : Script(share,s), keep(s.keep) {
          x.update ( *this, share, s.x );
       }
 
+      /// Restrict the search to the colorings with less than k colors
+      void tighten ( int k ) {
+         rel ( *this, x, IRT_LE, k );
+      }
+
+      /// On every restart, store in '*r' a copy of the master space with the
+      /// no-goods posted so far: they stay valid for any smaller number of
+      /// colors, hence the next search can start from that copy
+      void keepMaster ( GraphColoring** r ) {
+         keep = r;
+      }
+
+#if GECODE_VERSION_NUMBER >= 500000
+      /// Gecode 5 passes a MetaInfo, also for the portfolio calls
+      typedef MetaInfo MasterInfo;
+#elif GECODE_VERSION_NUMBER >= 400400
+      /// Gecode 4.4 passes a CRI, and calls master only on restarts
+      typedef CRI MasterInfo;
+#endif
+
+#if GECODE_VERSION_NUMBER >= 400400
+      virtual bool master ( const MasterInfo& mi ) {
+         bool r = Script::master(mi);
+#if GECODE_VERSION_NUMBER >= 500000
+         if ( mi.type() != MetaInfo::RESTART )
+            return r;
+#endif
+         if ( keep != NULL && status() != SS_FAILED ) {
+            GraphColoring* c = static_cast<GraphColoring*>(clone());
+            delete *keep;
+            *keep = c;
+         }
+         return r;
+      }
+#endif
+
       /// Perform copying during cloning
       virtual Space* copy(bool share) {
          return new GraphColoring(share, *this);
@@ -172,18 +575,20 @@ static double trampoline(const Space& home, IntVar x, int i) {
    return static_cast<const GraphColoring&>(home).merit(x,i);
 }
 
-/// Find upper bounds to coloring
+/// Find upper bounds to coloring, starting from the coloring 'initial'
+/// of value UB, until UB reaches the lower bound LB
 vector<int>
 colorHeuristic ( const graph_t*    g, 
-      int             n_c,        /// Number of cliques in "cliques"
-      const set_t*    cliques,
+      const vector<int>& initial,
+      const CliqueCover& cliques,
+      int             LB,
       int&            UB,
       double          time,
       int             n_threads
       )
 {
    /// For storing the coloring certificate
-   vector<int> certificate(g->n, 0);
+   vector<int> certificate(initial);
    vector<int> empty;
    /// Solution of the problem
    Support::Timer t;
@@ -191,25 +596,44 @@ colorHeuristic ( const graph_t*    g,
    /// Aux variables
    double elapsed;
    double ss = SCALE/10;
-   int tot_nodes = 0;
+   Search::Statistics total;
    int status = 1;
+   /// The model is built and propagated once, with UB-1 colors: every
+   /// iteration searches a clone of 'root' restricted to the new UB, and
+   /// 'root' is replaced on each restart by the master with the no-goods.
+   /// It is not built when the initial coloring is already optimal (with
+   /// UB = 1 its domains would be empty)
+   GraphColoring* root = NULL;
+   if ( UB > LB && UB > 1 ) {
+      root = new GraphColoring ( g, UB-1, cliques, empty );
+      root->keepMaster(&root);
+   }
    /// Search loop
    do {
+      if ( root == NULL || UB <= LB )
+         break;
       UB--; /// Find a coloring of better cost
 
-      GraphColoring* s = new GraphColoring ( g, UB, n_c, cliques, empty );
-      elapsed = time - t.stop();
+      if ( root->status() == SS_FAILED ) {
+         UB++;
+         break;
+      }
+      GraphColoring* s = static_cast<GraphColoring*>(root->clone());
+      s->tighten(UB);
+      double tstep = t.stop();
+      elapsed = time - tstep;
 
       if ( elapsed <= 1e-04 ) {
          fprintf(stdout,"\ttimeout of CP solver elapsed\n");
          status = 0;
+         delete s;
          break;
       }
 
       /// Search options
       Search::Cutoff* c = Search::Cutoff::geometric(1000,ss);
       Search::Options so;
-      so.stop = MyCutoff::create( elapsed );
+      so.stop = MyCutoff::create( elapsed, tstep/1000, UB+1 );
       so.threads = n_threads;
       so.clone   = false;
       so.cutoff  = c;
@@ -218,7 +642,7 @@ colorHeuristic ( const graph_t*    g,
 
       GraphColoring* ex = e.next();
       
-      tot_nodes += e.statistics().node;
+      total += e.statistics();
 
       if ( e.stopped() ) {
          fprintf(stdout,"\tWARNING: STOPPED, IT IS ONLY AN UPPER BOUND!\n");
@@ -232,14 +656,18 @@ colorHeuristic ( const graph_t*    g,
 
       if ( ex == NULL ) {
          UB++;
+         printStats("step", BRANCH, UB, e.stopped() ? 0 : 1, t.stop()/1000, 
+               (t.stop()-tstep)/1000, e.statistics());
          break;
       }
       UB = std::min(UB,ex->getChi());
       ex->getColoring(certificate);
       fprintf(stdout,"\t%.2f\t%d\t%ld\n", (t.stop()/1000), UB, e.statistics().node);
+      printStats("step", BRANCH, UB, 0, t.stop()/1000, (t.stop()-tstep)/1000, e.statistics());
 
       delete ex;
    } while ( time - t.stop() >= 0.001 );
+   delete root;
 
    double tend = t.stop()/1000;
    if ( tend > time-1e-05 ) {
@@ -247,17 +675,167 @@ colorHeuristic ( const graph_t*    g,
       status = 0;
    }
 
-   fprintf(stdout, "Nodes %d Time %.2f status %d X(G) %d \n", tot_nodes, tend, status, UB);
+   fprintf(stdout, "Nodes %lu Time %.2f status %d X(G) %d \n", total.node, tend, status, UB);
+   printStats("end", BRANCH, UB, status, tend, tend, total);
 
    return certificate;
 }
 
+/// A branching strategy of the portfolio, with its own restart scale and
+/// the statistics of the thread that runs it
+struct Strategy {
+   int                  branch;
+   double               scale;
+   const graph_t*       g;
+   const CliqueCover*   cliques;
+   Portfolio*           P;
+   double               time;
+   Search::Statistics   stats;    /// Sum over the searches of the thread
+   double               tbest;    /// Time of the last improvement of UB,
+                                  /// or of the proof of optimality
+   int                  status;   /// 1 if this thread proved optimality
+};
+
+/// Thread of the portfolio: the loop of colorHeuristic, where every search
+/// looks for a coloring with one color less than the shared upper bound
+void* portfolioThread ( void* arg ) {
+   Strategy*   S = (Strategy*)arg;
+   Portfolio*  P = S->P;
+   vector<int> empty;
+   vector<int> certificate(S->g->n, 0);
+   Support::Timer t;
+   t.start();
+   S->stats  = Search::Statistics();
+   S->tbest  = 0;
+   S->status = 0;
+   /// The model is built once, as in colorHeuristic, unless another thread
+   /// has already proved optimality
+   pthread_mutex_lock(&P->lock);
+   int UB0 = P->optimal ? 0 : P->UB;
+   pthread_mutex_unlock(&P->lock);
+   if ( UB0 == 0 )
+      return NULL;
+   GraphColoring* root = new GraphColoring ( S->g, UB0-1, *S->cliques, empty, S->branch );
+   root->keepMaster(&root);
+   while ( !P->optimal ) {
+      int    UB = P->UB-1;   /// Find a coloring of better cost
+      double tstep = t.stop();
+      double elapsed = S->time - tstep;
+      if ( elapsed <= 1e-04 || root->status() == SS_FAILED )
+         break;
+
+      GraphColoring* s = static_cast<GraphColoring*>(root->clone());
+      s->tighten(UB);
+      Search::Cutoff* c = Search::Cutoff::geometric(1000,S->scale);
+      PortfolioStop*  ps = new PortfolioStop( elapsed, P, UB, tstep/1000, S->branch );
+      Search::Options so;
+      so.stop    = ps;
+      so.threads = 1;
+      so.clone   = false;
+      so.cutoff  = c;
+      so.nogoods_limit = NOGOOD;
+      RBS<DFS,GraphColoring> e(s, so);
+
+      GraphColoring* ex = e.next();
+      S->stats += e.statistics();
+
+      bool timeout = e.stopped() && ps->stopTime(e.statistics(),so);
+      pthread_mutex_lock(&P->lock);
+      if ( ex != NULL ) {
+         ex->getColoring(certificate);
+         int chi = ex->getChi();
+         if ( chi < P->UB ) {
+            P->UB = chi;
+            P->certificate = certificate;
+            S->tbest = t.stop()/1000;
+            fprintf(stdout,"\t%.2f\t%d\t%lu\tbranch %d\n", S->tbest, chi, S->stats.node, S->branch);
+            if ( chi <= P->LB ) {
+               P->optimal = true;
+               S->status = 1;
+            }
+         }
+      } else if ( !e.stopped() ) {
+         /// No coloring with UB colors: the shared bound is optimal
+         P->optimal = true;
+         S->status = 1;
+         S->tbest  = t.stop()/1000;
+      }
+      printStats("step", S->branch, P->UB, S->status, t.stop()/1000, (t.stop()-tstep)/1000, 
+            e.statistics());
+      pthread_mutex_unlock(&P->lock);
+      delete ex;
+      delete ps;   /// The cutoff is deleted by the engine
+      if ( timeout )
+         break;
+   }
+   delete root;
+   return NULL;
+}
+
+/// Run the branching strategies in parallel, one thread each, on a shared
+/// upper bound: every thread searches for a coloring with one color less
+/// than the best one found so far by any thread, and all the threads stop
+/// as soon as one of them proves optimality, or UB reaches LB
+vector<int>
+colorPortfolio ( const graph_t*    g, 
+      const vector<int>& initial,
+      const CliqueCover& cliques,
+      int             LB,
+      int&            UB,
+      double          time,
+      vector<Strategy>& strategies
+      )
+{
+   Support::Timer t;
+   t.start();
+   Portfolio P;
+   pthread_mutex_init(&P.lock, NULL);
+   P.UB = UB;
+   P.LB = LB;
+   P.optimal = (UB <= LB || UB <= 1);
+   P.certificate = initial;
+
+   int k = strategies.size();
+   vector<pthread_t> tid(k);
+   for ( int i = 0; i < k; ++i ) {
+      strategies[i].g = g;
+      strategies[i].cliques = &cliques;
+      strategies[i].P = &P;
+      strategies[i].time = time;
+      pthread_create(&tid[i], NULL, portfolioThread, &strategies[i]);
+   }
+   Search::Statistics total;
+   for ( int i = 0; i < k; ++i ) {
+      pthread_join(tid[i], NULL);
+      total += strategies[i].stats;
+   }
+   pthread_mutex_destroy(&P.lock);
+
+   double tend = t.stop()/1000;
+   int status = P.optimal ? 1 : 0;
+   if ( tend > time-1e-05 ) {
+      tend = time;
+      status = 0;
+   }
+   UB = P.UB;
+   for ( int i = 0; i < k; ++i ) {
+      fprintf(stdout, "Strategy branch %d scale %.1f Nodes %lu Time %.2f status %d X(G) %d \n", 
+            strategies[i].branch, strategies[i].scale, strategies[i].stats.node, 
+            strategies[i].tbest, strategies[i].status, UB);
+      printStats("strategy", strategies[i].branch, UB, strategies[i].status, 
+            strategies[i].tbest, strategies[i].tbest, strategies[i].stats);
+   }
+   fprintf(stdout, "Nodes %lu Time %.2f status %d X(G) %d \n", total.node, tend, status, UB);
+   printStats("end", -1, UB, status, tend, tend, total);
+
+   return P.certificate;
+}
+
 /// Find the final certificate
 vector<int>
 colorFinal ( const graph_t*    g, 
       vector<int>&    initial,
-      int             n_c,        /// Number of cliques in "cliques"
-      const set_t*    cliques,
+      const CliqueCover& cliques,
       int             UB,
       int             n_threads
       )
@@ -271,7 +849,7 @@ colorFinal ( const graph_t*    g,
    so.threads = n_threads;
    so.clone   = false;
 
-   GraphColoring* s = new GraphColoring ( g, UB, n_c, cliques, initial );
+   GraphColoring* s = new GraphColoring ( g, UB, cliques, initial );
    DFS<GraphColoring> e(s, so);
    GraphColoring* ex = e.next();
    if ( ex == NULL ) {
@@ -286,14 +864,232 @@ colorFinal ( const graph_t*    g,
    return certificate;
 }
 
+/// Upper bound on the colors of 'g' by DSATUR and TabuCol, with one run
+/// for each thread: the coloring is stored in 'certificate', and its value
+/// is returned
+int colorLocalSearch ( graph_t* g, int LB, int n_threads, vector<int>& certificate ) {
+   int n = g->n;
+   tc_options_t opt;
+   opt.max_iter = LS_ITER;
+   opt.threads  = n_threads;
+   opt.lb       = LB;
+   opt.seed     = 13;
+   certificate.assign(n, 0);
+#if ELEMENTSIZE == 64
+   int k = tc_color(n, (word_t* const*)g->edges, &certificate[0], &opt);
+#else
+   int w = BS_WORDS(n);
+   vector<word_t>  rows((size_t)n*w, 0);
+   vector<word_t*> adj(n);
+   for ( int i = 0; i < n; ++i ) {
+      adj[i] = &rows[(size_t)i*w];
+      for ( int j = set_return_next(g->edges[i], -1); j >= 0; j = set_return_next(g->edges[i], j) )
+         if ( j != i )
+            BS_ADD(adj[i], j);
+   }
+   int k = tc_color(n, &adj[0], &certificate[0], &opt);
+#endif
+   fprintf(stdout,"Local search: UB %d DSATUR %d iterations %ld\n", k, opt.greedy, opt.iter);
+   return k;
+}
+
+/// Lower bound on the colors of 'g' by column generation, starting from
+/// the columns of 'coloring', within CG_TIME seconds
+int colorLowerBound ( graph_t* g, const vector<int>& coloring ) {
+   int n = g->n;
+   cg_stats_t st;
+   st.time_limit = CG_TIME;
+   st.max_nodes  = 100000;
+#if ELEMENTSIZE == 64
+   int k = cg_lower_bound(n, (word_t* const*)g->edges, &coloring[0], &st);
+#else
+   int w = BS_WORDS(n);
+   vector<word_t>  rows((size_t)n*w, 0);
+   vector<word_t*> adj(n);
+   for ( int i = 0; i < n; ++i ) {
+      adj[i] = &rows[(size_t)i*w];
+      for ( int j = set_return_next(g->edges[i], -1); j >= 0; j = set_return_next(g->edges[i], j) )
+         if ( j != i )
+            BS_ADD(adj[i], j);
+   }
+   int k = cg_lower_bound(n, &adj[0], &coloring[0], &st);
+#endif
+   fprintf(stdout,"Column generation: LB %d LP %.3f optimal %d columns %d pivots %ld\n", 
+         k, st.lp, st.optimal, st.columns, st.pivots);
+   return k;
+}
+
+/// Maximum clique of 'g' with the bit-parallel solver: the search stops
+/// after 'max_nodes' nodes, and then the best clique found is returned.
+/// The initial clique comes from 'ls_moves' moves of local search.
+/// The solver gets only the vertices with at least one edge, which after
+/// the peeling and the cover of the first cliques are few: 'active' lists
+/// the vertices that may have edges, and the isolated ones are dropped from
+/// it, since the graph only loses edges between calls. With 64-bit set
+/// elements the rows of Cliquer are already bitsets in the layout of
+/// bitset.h, and if no vertex is isolated they are passed as they are
+set_t findMaxClique ( graph_t* g, long max_nodes, long ls_moves, vector<int>& active ) {
+   int n = g->n;
+   set_t s = set_new(n);
+   vector<int> idx(n, -1);
+   int na = 0;
+   for ( size_t a = 0; a < active.size(); ++a )
+      if ( set_return_next(g->edges[active[a]], -1) >= 0 ) {
+         idx[active[a]] = na;
+         active[na++] = active[a];
+      }
+   active.resize(na);
+   if ( na == 0 ) {   /// No edges: any vertex is a maximum clique
+      if ( n > 0 )
+         SET_ADD_ELEMENT(s, 0);
+      return s;
+   }
+   vector<int>     clique(na);
+   mc_stats_t      st;
+   st.max_nodes = max_nodes;
+   st.ls_moves  = ls_moves;
+   int size;
+#if ELEMENTSIZE == 64
+   if ( na == n )
+      size = mc_max_clique(n, (word_t* const*)g->edges, &clique[0], &st);
+   else
+#endif
+   {
+      int w = BS_WORDS(na);
+      vector<word_t>  rows((size_t)na*w, 0);
+      vector<word_t*> adj(na);
+      for ( int a = 0; a < na; ++a ) {
+         adj[a] = &rows[(size_t)a*w];
+         for ( int j = set_return_next(g->edges[active[a]], -1); j >= 0; j = set_return_next(g->edges[active[a]], j) )
+            if ( j != active[a] )
+               BS_ADD(adj[a], idx[j]);
+      }
+      size = mc_max_clique(na, &adj[0], &clique[0], &st);
+   }
+   for ( int i = 0; i < size; ++i )
+      SET_ADD_ELEMENT(s, active[clique[i]]);
+   return s;
+}
+
+/// State of the clique cover by enumeration (see coverCliques)
+struct CoverState {
+   graph_t*      h;
+   CliqueCover*  Cs;
+   set_t         s;
+   int           LB;
+   int           edges;   /// Edges of 'h' not covered yet
+};
+
+/// Callback of bk_maximal_cliques: the clique v[0..k) joins the cover if at
+/// least k-1 of its edges are still in 'h', and then they are removed from
+/// 'h'. The enumeration stops once every edge is covered
+int coverClique ( const int* v, int k, void* data ) {
+   CoverState* S = (CoverState*)data;
+   int fresh = 0;
+   for ( int j = 0; j < k; ++j )
+      for ( int l = j+1; l < k; ++l )
+         if ( GRAPH_IS_EDGE(S->h,v[j],v[l]) )
+            fresh++;
+   if ( fresh < k-1 )
+      return 1;
+   set_empty(S->s);
+   for ( int j = 0; j < k; ++j )
+      SET_ADD_ELEMENT(S->s, v[j]);
+   if ( k > S->LB ) {
+      S->LB = k;
+      set_copy(C,S->s);  /// C is the best maximal clique found
+   }
+   if ( S->Cs->add(S->s) ) {
+      for ( int j = 0; j < k; ++j )
+         for ( int l = j+1; l < k; ++l )
+            if ( GRAPH_IS_EDGE(S->h,v[j],v[l]) )
+               GRAPH_DEL_EDGE(S->h,v[j],v[l]);
+      S->edges -= fresh;
+   }
+   return S->edges > 0;
+}
+
+/// Cover the edges of 'h' with the maximal cliques of 'g', enumerated by
+/// Bron-Kerbosch in output-sensitive time, within 'max_nodes' nodes: the
+/// edges left uncovered are covered by the loop on the maximum cliques of
+/// 'h'. Returns the size of the largest clique found, if larger than 'LB'
+int coverCliques ( graph_t* g, graph_t* h, CliqueCover& Cs, int LB, long max_nodes ) {
+   int n = g->n;
+   bk_stats_t st;
+   memset(&st, 0, sizeof(st));
+   st.max_nodes = max_nodes;
+   st.min_size  = 2;
+   CoverState S = { h, &Cs, set_new(n), LB, graph_edge_count(h) };
+   if ( S.edges > 0 ) {
+#if ELEMENTSIZE == 64
+      bk_maximal_cliques(n, (word_t* const*)g->edges, coverClique, &S, &st);
+#else
+      int w = BS_WORDS(n);
+      vector<word_t>  rows((size_t)n*w, 0);
+      vector<word_t*> adj(n);
+      for ( int i = 0; i < n; ++i ) {
+         adj[i] = &rows[(size_t)i*w];
+         for ( int j = set_return_next(g->edges[i], -1); j >= 0; j = set_return_next(g->edges[i], j) )
+            if ( j != i )
+               BS_ADD(adj[i], j);
+      }
+      bk_maximal_cliques(n, &adj[0], coverClique, &S, &st);
+#endif
+   }
+   fprintf(stdout,"Clique enumeration: cliques %ld nodes %ld degeneracy %d uncovered %d\n",
+         st.cliques, st.nodes, st.degeneracy, S.edges);
+   set_free(S.s);
+   return S.LB;
+}
+
+/// Remove from 'g' (and from 'h') the edges of every vertex whose degree
+/// is smaller than 'k', until none is left (k-core peeling). 'deg' holds
+/// the degrees in 'g' and is kept up to date across calls, so that after a
+/// better lower bound only the new low degree vertices are peeled. Returns
+/// the number of edges removed
+int peelCore ( graph_t* g, graph_t* h, int k, vector<int>& deg ) {
+   int n = g->n;
+   int n_r = 0;
+   vector<int>  queue;
+   vector<char> queued(n, 0);
+   for ( int i = 0; i < n; ++i )
+      if ( deg[i] > 0 && deg[i] < k ) {
+         queue.push_back(i);
+         queued[i] = 1;
+      }
+   for ( size_t q = 0; q < queue.size(); ++q ) {
+      int i = queue[q];
+      for ( int j = set_return_next(g->edges[i], -1); j >= 0; j = set_return_next(g->edges[i], j) ) {
+         GRAPH_DEL_EDGE(g,i,j);
+         if ( GRAPH_IS_EDGE(h,i,j) )
+            GRAPH_DEL_EDGE(h,i,j);
+         n_r++;
+         deg[i]--;
+         if ( --deg[j] < k && !queued[j] ) {
+            queue.push_back(j);
+            queued[j] = 1;
+         }
+      }
+   }
+   return n_r;
+}
+
 /// MAIN PROGRAM
 int main(int argc, char **argv)
 {
    if ( argc == 1 ) {
-      fprintf(stdout, "\nusage:  $ ./GeCol <filename> <branch> <restart> <ub>\n\n");
+      fprintf(stdout, "\nusage:  $ ./GeCol <filename> <branch> <restart> <ub>\n");
+      fprintf(stdout, "  with <branch> a list as 1,2,7:20 runs a portfolio, one thread per\n");
+      fprintf(stdout, "  branching (with an optional restart scale)\n");
+      fprintf(stdout, "  further arguments: <prop> <ub> <nogood> <tabucol iter> <stats ms> <cg s>,\n");
+      fprintf(stdout, "  where <stats ms> is the interval of the JSON progress lines (0 for none)\n");
+      fprintf(stdout, "  and <cg s> the time limit of the column generation bound (0 for none)\n\n");
       exit(EXIT_SUCCESS);
    }
 
+   /// Line buffered output, so that the bounds can be followed from a pipe
+   setvbuf(stdout, NULL, _IOLBF, 0);
+
    if ( argc >= 3 )
       BRANCH = atoi(argv[2]);
    else
@@ -302,6 +1098,18 @@ int main(int argc, char **argv)
    if ( argc >= 4 )
       SCALE = atoi(argv[3]);
 
+   /// Portfolio of branching strategies, as "branch[:restart],..."
+   vector<Strategy> strategies;
+   if ( argc >= 3 && strchr(argv[2], ',') != NULL ) {
+      for ( char* tok = strtok(argv[2], ","); tok != NULL; tok = strtok(NULL, ",") ) {
+         Strategy S;
+         S.branch = atoi(tok);
+         char* sc = strchr(tok, ':');
+         S.scale  = ((sc != NULL) ? atoi(sc+1) : SCALE)/10;
+         strategies.push_back(S);
+      }
+   }
+
    if ( argc >= 5 )
       PROP = atoi(argv[4]);
 
@@ -311,41 +1119,39 @@ int main(int argc, char **argv)
    if ( argc >= 7 )
       NOGOOD = atoi(argv[6]);
 
+   if ( argc >= 8 )
+      LS_ITER = atol(argv[7]);
+
+   if ( argc >= 9 )
+      STATS = atoi(argv[8]);
+
+   if ( argc >= 10 )
+      CG_TIME = atof(argv[9]);
+
    int  timeout = 600*1000;  /// in seconds
    int  threads = 1;
    
-   clique_options* opts;
    graph_t* g;  
    graph_t* g0;  
    graph_t* h;  
    graph_t* G;  
-   set_t*   Cs;        /// Collection of maximal cliques
+   CliqueCover Cs;     /// Collection of maximal cliques
    int*     table;
 
-   /// Set the options for using Cliquer
-   opts = (clique_options*) malloc (sizeof(clique_options));
-   opts->time_function=NULL;
-   opts->reorder_function=reorder_by_greedy_coloring;
-   opts->reorder_map=NULL;
-   opts->user_function=NULL;
-   opts->user_data=NULL;
-   opts->clique_list=NULL;
-   opts->clique_list_length=0;
-
-
    /// Read a graph instance in any DIMACS format (binary or ascii)
    g0 = graph_read_dimacs_file(argv[1]);
    table = reorder_by_degree(g0,FALSE);
 
    int n = g0->n;
    int m = graph_edge_count(g0);
-   int n_c = 0;   /// Number of maximal cliques found
    int UB = n;
    if ( UB0 != -1 )
       UB = UB0;
    int LB = 0;
-   set_t s = set_new(n);
+   set_t s = NULL;
    float density = (float)m/(n*(n-1)/2);
+   long  max_nodes = 1000000;  /// Node limit of the search for the lower bound
+   long  cover_nodes = 10000;  /// ... and of each search of the clique cover
    
    /// Reorder the graph
    g = graph_new(n);
@@ -362,49 +1168,42 @@ int main(int argc, char **argv)
             inver[table[j]] = j;
          }
 
-   /// Allocate space to store maximal cliques
-   Cs = (set_t*)malloc(m*sizeof(set_t));
    C  = set_new(n);
 
    Support::Timer t;
    t.start();
   
    /// Start with a maximal clique as lower bound
-   if ( density > 0.0 )
-      s = clique_find_single ( g, 2, 0, TRUE, opts);
-   else
-      s = clique_find_single ( g, 0, 0, TRUE, opts);
+   vector<int> active(n);
+   for ( int i = 0; i < n; ++i )
+      active[i] = i;
+   s = findMaxClique ( g, max_nodes, MC_LS_MOVES, active );
    maximalize_clique(s,g);
-   if ( s != NULL && set_size(s) > LB ) {
+   if ( set_size(s) > LB ) {
       LB = set_size(s);
       set_copy(C,s);  /// C is the best maximal clique found
    }
-   bool removed = true;
-   int  n_r = 0;
-   while ( removed ) {
-      removed = false;
-      for ( int i = 0; i < n; ++i ) {
-         if ( graph_vertex_degree(g, i) < LB-1 ) { 
-            for ( int j = 0; j < n ; ++j )
-               if ( GRAPH_IS_EDGE(g,i,j) ) {
-                  GRAPH_DEL_EDGE(g,i,j);
-                  GRAPH_DEL_EDGE(h,i,j);
-                  n_r++;
-                  removed = true;
-               }
-         }
-      }
+   vector<int> deg(n);
+   for ( int i = 0; i < n; ++i )
+      deg[i] = graph_vertex_degree(g, i);
+   int  n_r = peelCore ( g, h, LB-1, deg );
+
+   /// Cover the edges with the maximal cliques enumerated first, and then
+   /// with the maximum cliques of what is left
+   int  k = coverCliques ( g, h, Cs, LB, max_nodes );
+   if ( k > LB ) {
+      LB = k;
+      n_r += peelCore ( g, h, LB-1, deg );
    }
 
    /// Loop until at least a vertex is removed
-   while ( graph_edge_count(h) > 0 ) {
+   while ( true ) {
       bool flag = false;
       /// Find a maximal clique for every vertex, and store the largest
-      float density = (float)graph_edge_count(h)/(n*(n-1)/2);
-      if ( density > 0.0 )
-         s = clique_find_single ( h, 2, 0, TRUE, opts);
-      else
-         s = clique_find_single ( h, 0, 0, TRUE, opts);
+      set_free(s);
+      s = findMaxClique ( h, cover_nodes, 0, active );
+      if ( set_size(s) < 2 )   /// No edge left in h
+         break;
       maximalize_clique(s,g);
       if ( s != NULL ) {
          if ( set_size(s) > LB ) {
@@ -412,76 +1211,84 @@ int main(int argc, char **argv)
             set_copy(C,s);  /// C is the best maximal clique found
             flag = true;
          } 
-         Cs[n_c++]=set_duplicate(s);
-         /// Rimuovi tutti gli archi contenuti nella clique
-         for ( int j = 0; j < n; ++j )
-            if ( SET_CONTAINS_FAST(s,j) )
-               for ( int l = j+1; l < n; ++l )
-                  if ( SET_CONTAINS_FAST(s,l) && GRAPH_IS_EDGE(h,j,l) )
-                     GRAPH_DEL_EDGE(h,j,l);
+         /// Remove the edges of the clique (only its vertices are scanned)
+         if ( Cs.add(s) ) {
+            const int* v = Cs[Cs.count()-1];
+            int        k = Cs.size(Cs.count()-1);
+            for ( int j = 0; j < k; ++j )
+               for ( int l = j+1; l < k; ++l )
+                  if ( GRAPH_IS_EDGE(h,v[j],v[l]) )
+                     GRAPH_DEL_EDGE(h,v[j],v[l]);
+         }
       }
 
       /// Reduce the graph (if degree smaller than LB, then remove the vertex)
       if ( flag )
-         for ( int i = 0; i < n; ++i ) {
-            if ( graph_vertex_degree(g, i) < LB-1 ) { 
-               for ( int j = 0; j < n ; ++j )
-                  if ( GRAPH_IS_EDGE(g,i,j) ) {
-                     GRAPH_DEL_EDGE(g,i,j);
-                     if ( GRAPH_IS_EDGE(h,i,j) )
-                        GRAPH_DEL_EDGE(h,i,j);
-                     n_r++;
-                  }
-            }
-         }
+         n_r += peelCore ( g, h, LB-1, deg );
    }
 
-   /// Remove duplicate cliques
-   int n_d = n_c;
-   for ( int i = 0; i < n_c-1 ; i++ ) {
-      for ( int j = i+1; j < n_c ; j++ ) {
-         if ( set_size(Cs[i]) == set_size(Cs[j]) ) {
-            set_t res = set_new(n);
-            set_intersection(res, Cs[i], Cs[j]);
-            if ( set_size(Cs[i]) == set_size(res) ) {
-               Cs[i] = set_new(n);
-               n_d--;
-            }
-         }
-      }
-   }
+   Cs.index(n);   /// For the coloring propagator
 
    fprintf(stdout,"Graph: n %d m %d density %.2f\n", n, m, density);
-   fprintf(stdout,"Algo: branch %d scale %.1f propagation %d\n", BRANCH, SCALE/10, PROP);
-   fprintf(stdout,"Preprocessing: LB %d edges_removed %d cliques %d\n", LB, n_r, n_d);
+   if ( strategies.empty() )
+      fprintf(stdout,"Algo: branch %d scale %.1f propagation %d\n", BRANCH, SCALE/10, PROP);
+   else {
+      fprintf(stdout,"Algo: portfolio");
+      for ( size_t i = 0; i < strategies.size(); ++i )
+         fprintf(stdout," %d:%.1f", strategies[i].branch, strategies[i].scale);
+      fprintf(stdout," propagation %d\n", PROP);
+   }
+   fprintf(stdout,"Preprocessing: LB %d edges_removed %d cliques %d\n", LB, n_r, Cs.count());
 
    /// Stats on cliques
    int mm = 0;
-   for ( int i = 0; i < n_c; i++ )
-      if ( set_size(Cs[i]) == LB ) {
+   for ( int i = 0; i < Cs.count(); i++ )
+      if ( Cs.size(i) == LB ) {
          int dd = 0;
-         for ( int j = 0; j < n; ++j )
-            if ( SET_CONTAINS(Cs[i],j) )
-               dd += graph_vertex_degree(g,j);
+         for ( int j = 0; j < Cs.size(i); ++j )
+            dd += deg[Cs[i][j]];
          if ( dd > mm ) {
             mm = dd;
-            set_copy(C, Cs[i]);  /// C is the best maximal clique found
+            set_empty(C);  /// C is the best maximal clique found
+            for ( int j = 0; j < Cs.size(i); ++j )
+               SET_ADD_ELEMENT(C, Cs[i][j]);
          }
       } 
 
    /// Dump instance
-  /* fprintf(stdout,"%d %d %d\n", n, n_c, UB);
-   for ( int i = 0; i < n_c; ++i ) {
-      fprintf(stdout, "%d ", set_size(Cs[i]));
-      for ( int j = 0; j < n; ++j )
-         if ( SET_CONTAINS(Cs[i],j) )
-            fprintf(stdout, "%d ", j+1);
+  /* fprintf(stdout,"%d %d %d\n", n, Cs.count(), UB);
+   for ( int i = 0; i < Cs.count(); ++i ) {
+      fprintf(stdout, "%d ", Cs.size(i));
+      for ( int j = 0; j < Cs.size(i); ++j )
+         fprintf(stdout, "%d ", Cs[i][j]+1);
       fprintf(stdout, "\n");
    }*/
    
+   /// Start the CP model from the local search coloring of the core
+   vector<int> initial;
+   int UBls = colorLocalSearch ( g, LB, strategies.empty() ? threads : strategies.size(), initial );
+   if ( UBls <= UB ) {
+      UB = UBls;
+      /// The LP bound of column generation is often far above the clique:
+      /// it peels more vertices, and stops the CP model as soon as reached
+      if ( LB < UB && CG_TIME > 0 ) {
+         int LBcg = colorLowerBound ( g, initial );
+         if ( LBcg > LB ) {
+            LB = LBcg;
+            n_r += peelCore ( g, h, LB-1, deg );
+         }
+      }
+   } else
+      initial.assign(n, 0);
+
    /// Call the CP model 
-   fprintf(stdout, "Run CP model with LB %d - Preproc time %.3f\n", LB, t.stop()/1000);
-   vector<int> certificate = colorHeuristic ( g, n_c, Cs, UB, timeout, threads );
+   fprintf(stdout, "Run CP model with LB %d UB %d - Preproc time %.3f\n", LB, UB, t.stop()/1000);
+   fprintf(stdout, "{\"event\":\"preprocessing\",\"n\":%d,\"m\":%d,\"lb\":%d,\"ub\":%d,"
+         "\"cliques\":%d,\"edges_removed\":%d,\"time\":%.3f,\"memory\":%ld}\n",
+         n, m, LB, UB, Cs.count(), n_r, t.stop()/1000, peakMemory());
+   vector<int> certificate = strategies.empty() 
+      ? colorHeuristic ( g, initial, Cs, LB, UB, timeout, threads )
+      : colorPortfolio ( g, initial, Cs, LB, UB, timeout, strategies );
    
    for ( int i = 0; i < n-1; ++i ) 
       for ( int j = i+1; j < n ; ++j )
@@ -492,10 +1299,10 @@ int main(int argc, char **argv)
    
    /// Costruct the final coloring
    for ( int i = 0; i < n; ++i )
-      if ( graph_vertex_degree(g,i) < LB )
+      if ( deg[i] < LB )
          certificate[i] = 0;
 
-   vector<int> sol = colorFinal ( G, certificate, n_c, Cs, UB, threads );
+   vector<int> sol = colorFinal ( G, certificate, Cs, UB, threads );
 
    for ( int i = 0; i < n-1; ++i ) 
       for ( int j = i+1; j < n ; ++j )
@@ -514,8 +1321,6 @@ int main(int argc, char **argv)
       set_free(s);
    if ( C != NULL )
       set_free(C);
-   free(Cs);
-   free(opts);
    graph_free(g0);
    graph_free(g);
    graph_free(h);
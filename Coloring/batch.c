@@ -0,0 +1,482 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Batch runner of the coloring solvers (dsatur, GeCol) over a suite of
+ *  instances. Every instance is streamed to the solver through a pipe, as
+ *  a DIMACS graph on /dev/stdin: .col files (plain or gzipped) are copied
+ *  as they are, while .mps(.gz) files are the set covering models of the
+ *  maximal stable sets shipped with GeCol, and the graph is recovered as
+ *  the pairs of rows never covered by the same column. zlib reads both
+ *  plain and gzipped files, and no temporary file is written.
+ *
+ *  usage: ./batch [-j jobs] [-t seconds] -c "<solver> <args>" [-c ...] <instances>
+ *
+ *  Every configuration is a command line, and the instance is passed as
+ *  its first argument. Each run writes one JSON line on stdout, with the
+ *  wall time, the nodes, the final bounds, and their trajectory as
+ *  [time, lb, ub] triples; at the end a table is written on stderr. Runs
+ *  longer than the time limit are killed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <zlib.h>
+
+#include "bitset.h"
+
+#define MAX_CONF   32
+#define MAX_ARGS   32
+#define LINE_LEN   4096
+
+/// One run: a configuration on an instance
+typedef struct {
+   const char  *inst;
+   int          conf;
+   pid_t        pid;        /* solver */
+   pid_t        feeder;     /* writes the instance into the solver stdin */
+   int          fd;         /* solver stdout */
+   double       start;
+   double       time;
+   char         buf[LINE_LEN];
+   int          len;
+   int          lb, ub;
+   long         nodes;      /* total of the search, if reported */
+   long         step_nodes; /* sum of the nodes of the steps of GeCol */
+   int          optimal;
+   int          timeout;
+   int          error;
+   double      *traj;       /* time, lb, ub */
+   int          ntraj, maxtraj;
+} run_t;
+
+static char  *conf_line[MAX_CONF];
+static char  *conf_argv[MAX_CONF][MAX_ARGS+2];
+static int    nconf = 0;
+
+static double now(void) {
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec*1e-6;
+}
+
+static int ends_with(const char* s, const char* suffix) {
+   size_t n = strlen(s), m = strlen(suffix);
+   return n >= m && strcmp(s+n-m, suffix) == 0;
+}
+
+/// Split a configuration on blanks: the instance goes in place of argv[1]
+static void parse_conf(char* line) {
+   char  *tok;
+   int    k = 0;
+   char **argv = conf_argv[nconf];
+   conf_line[nconf] = strdup(line);
+   for ( tok = strtok(line, " \t"); tok != NULL && k < MAX_ARGS; tok = strtok(NULL, " \t") ) {
+      argv[k++] = tok;
+      if ( k == 1 )
+         argv[k++] = "/dev/stdin";
+   }
+   argv[k] = NULL;
+   if ( k > 0 )
+      nconf++;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Instances                                                                  */
+/*----------------------------------------------------------------------------*/
+
+/// Copy a DIMACS graph as it is
+static int feed_col(gzFile in, FILE* out) {
+   char buf[1 << 16];
+   int  len;
+   while ( (len = gzread(in, buf, sizeof(buf))) > 0 )
+      if ( fwrite(buf, 1, len, out) != (size_t)len )
+         return 0;
+   return len == 0;
+}
+
+/// Hash table of the row names of an MPS file
+typedef struct {
+   char   **key;
+   int     *val;
+   int      size;
+} names_t;
+
+static unsigned int hash(const char* s) {
+   unsigned int h = 2166136261u;
+   while ( *s )
+      h = (h ^ (unsigned char)*s++) * 16777619u;
+   return h;
+}
+
+static int names_find(names_t* T, const char* s, int add) {
+   unsigned int i = hash(s) & (T->size-1);
+   while ( T->key[i] != NULL ) {
+      if ( strcmp(T->key[i], s) == 0 )
+         return T->val[i];
+      i = (i+1) & (T->size-1);
+   }
+   if ( add < 0 )
+      return -1;
+   T->key[i] = strdup(s);
+   T->val[i] = add;
+   return add;
+}
+
+/// Set covering model of the maximal stable sets: a row for each vertex,
+/// a column for each stable set. Two vertices are adjacent if and only if
+/// no column covers both rows, since every stable set of two vertices is
+/// in a maximal one
+static int feed_mps(gzFile in, FILE* out) {
+   char       line[LINE_LEN], prev[256] = "", col[256], row[256], sec[32] = "";
+   names_t    T;
+   int        n = 0, ok = 1, w = 0, i, j, u, v, len = 0, max_len = 64;
+   int       *rows = (int*) malloc(max_len*sizeof(int));
+   word_t    *stable = NULL;
+   long       m = 0;
+
+   T.size = 1 << 10;
+   T.key = (char**) calloc(T.size, sizeof(char*));
+   T.val = (int*) malloc(T.size*sizeof(int));
+   while ( ok ) {
+      int eof = (gzgets(in, line, sizeof(line)) == NULL);
+      if ( !eof && line[0] != ' ' && line[0] != '\t' ) {
+         if ( sscanf(line, "%31s", sec) != 1 )
+            continue;
+         if ( strcmp(sec, "COLUMNS") == 0 && stable == NULL ) {
+            w = BS_WORDS(n);
+            stable = (word_t*) calloc((size_t)n*w, sizeof(word_t));
+         }
+         if ( strcmp(sec, "ENDATA") != 0 )
+            continue;
+         eof = 1;
+      }
+      if ( !eof && strcmp(sec, "ROWS") == 0 ) {
+         char type[8];
+         if ( sscanf(line, "%7s %255s", type, row) != 2 || type[0] == 'N' )
+            continue;
+         if ( 2*(n+1) > T.size ) {   /// Grow the table
+            names_t G;
+            G.size = 2*T.size;
+            G.key = (char**) calloc(G.size, sizeof(char*));
+            G.val = (int*) malloc(G.size*sizeof(int));
+            for ( i = 0; i < T.size; ++i )
+               if ( T.key[i] != NULL ) {
+                  names_find(&G, T.key[i], T.val[i]);
+                  free(T.key[i]);
+               }
+            free(T.key);
+            free(T.val);
+            T = G;
+         }
+         if ( names_find(&T, row, n) == n )
+            n++;
+         continue;
+      }
+      if ( !eof && (strcmp(sec, "COLUMNS") != 0 || strstr(line, "MARKER") != NULL) )
+         continue;
+      /// A column ends: mark its pairs of rows
+      if ( eof || (sscanf(line, "%255s %255s", col, row) == 2 && strcmp(col, prev) != 0) ) {
+         for ( i = 0; i < len; ++i )
+            for ( j = 0; j < len; ++j )
+               BS_ADD(stable + (size_t)rows[i]*w, rows[j]);
+         len = 0;
+         strcpy(prev, col);
+      }
+      if ( eof )
+         break;
+      /// Up to two (row, value) pairs for each line
+      {
+         char r1[256], r2[256];
+         double a1, a2;
+         int k = sscanf(line, "%*s %255s %lf %255s %lf", r1, &a1, r2, &a2);
+         for ( i = 0; i < k/2; ++i ) {
+            u = names_find(&T, i == 0 ? r1 : r2, -1);
+            if ( u < 0 || (i == 0 ? a1 : a2) == 0 )
+               continue;
+            if ( len == max_len ) {
+               max_len *= 2;
+               rows = (int*) realloc(rows, max_len*sizeof(int));
+            }
+            rows[len++] = u;
+         }
+      }
+   }
+
+   if ( stable == NULL )
+      ok = 0;
+   else {
+      for ( u = 0; u < n; ++u ) {
+         BS_ADD(stable + (size_t)u*w, u);
+         m += n - bs_count(stable + (size_t)u*w, w);
+      }
+      fprintf(out, "p edge %d %ld\n", n, m/2);
+      for ( u = 0; u < n && ok; ++u )
+         for ( v = u+1; v < n; ++v )
+            if ( !BS_CONTAINS(stable + (size_t)u*w, v) && fprintf(out, "e %d %d\n", u+1, v+1) < 0 ) {
+               ok = 0;
+               break;
+            }
+   }
+   for ( i = 0; i < T.size; ++i )
+      free(T.key[i]);
+   free(T.key);
+   free(T.val);
+   free(stable);
+   free(rows);
+   return ok;
+}
+
+/// Feeder process: write the instance as a DIMACS graph on 'fd'
+static void feed(const char* inst, int fd) {
+   FILE*  out = fdopen(fd, "w");
+   gzFile in  = gzopen(inst, "rb");
+   int    ok;
+   if ( in == NULL || out == NULL ) {
+      fprintf(stderr, "batch: cannot read %s\n", inst);
+      _exit(EXIT_FAILURE);
+   }
+   if ( ends_with(inst, ".mps") || ends_with(inst, ".mps.gz") )
+      ok = feed_mps(in, out);
+   else
+      ok = feed_col(in, out);
+   gzclose(in);
+   if ( fclose(out) != 0 )
+      ok = 0;
+   _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/*----------------------------------------------------------------------------*/
+/* Runs                                                                       */
+/*----------------------------------------------------------------------------*/
+
+static void start_run(run_t* R) {
+   int in[2], out[2];
+   if ( pipe(in) != 0 || pipe(out) != 0 ) {
+      perror("batch: pipe");
+      exit(EXIT_FAILURE);
+   }
+   R->start = now();
+   R->pid = fork();
+   if ( R->pid == 0 ) {
+      dup2(in[0], STDIN_FILENO);
+      dup2(out[1], STDOUT_FILENO);
+      close(in[0]); close(in[1]);
+      close(out[0]); close(out[1]);
+      execvp(conf_argv[R->conf][0], conf_argv[R->conf]);
+      perror("batch: exec");
+      _exit(127);
+   }
+   R->feeder = fork();
+   if ( R->feeder == 0 ) {
+      close(in[0]);
+      close(out[0]); close(out[1]);
+      feed(R->inst, in[1]);
+   }
+   close(in[0]);
+   close(in[1]);
+   close(out[1]);
+   R->fd = out[0];
+}
+
+/// Append a point to the trajectory, if a bound changed
+static void update(run_t* R, int lb, int ub) {
+   if ( lb > R->lb )
+      R->lb = lb;
+   if ( ub > 0 && (R->ub < 0 || ub < R->ub) )
+      R->ub = ub;
+   if ( R->ntraj > 0 && R->traj[3*R->ntraj-2] == R->lb && R->traj[3*R->ntraj-1] == R->ub )
+      return;
+   if ( R->ntraj == R->maxtraj ) {
+      R->maxtraj = 2*R->maxtraj + 8;
+      R->traj = (double*) realloc(R->traj, 3*R->maxtraj*sizeof(double));
+   }
+   R->traj[3*R->ntraj]   = now() - R->start;
+   R->traj[3*R->ntraj+1] = R->lb;
+   R->traj[3*R->ntraj+2] = R->ub;
+   R->ntraj++;
+}
+
+static long json_long(const char* line, const char* key, long def) {
+   const char* p = strstr(line, key);
+   return (p != NULL) ? atol(p + strlen(key)) : def;
+}
+
+/// Bounds and nodes from a line of the solver output: the JSON lines of
+/// GeCol, and the text lines of dsatur
+static void parse_line(run_t* R, const char* line) {
+   const char* p;
+   int         v;
+   if ( line[0] == '{' ) {
+      long lb = json_long(line, "\"lb\":", 0), ub = json_long(line, "\"ub\":", -1);
+      if ( strstr(line, "\"event\":\"step\"") != NULL )
+         R->step_nodes += json_long(line, "\"node\":", 0);
+      if ( strstr(line, "\"event\":\"end\"") != NULL ) {
+         R->nodes = json_long(line, "\"node\":", 0);
+         if ( json_long(line, "\"status\":", 0) == 1 ) {
+            R->optimal = 1;
+            lb = ub;
+         }
+      }
+      update(R, (int)lb, (int)ub);
+   }
+   else if ( sscanf(line, "Lower bound is %d", &v) == 1 || sscanf(line, "LP bound is %d", &v) == 1 )
+      update(R, v, -1);
+   else if ( sscanf(line, "Upper bound is %d", &v) == 1 || sscanf(line, "Best coloring is %d", &v) == 1 )
+      update(R, 0, v);
+   else if ( sscanf(line, "Best coloring has value %d", &v) == 1 ) {
+      R->optimal = 1;
+      update(R, v, v);
+   }
+   if ( (p = strstr(line, "subproblems: ")) != NULL )
+      R->nodes = atol(p + 13);
+   if ( strncmp(line, "ERROR", 5) == 0 )
+      R->error = 1;
+}
+
+/// Read the solver output; returns 0 at the end of it
+static int read_run(run_t* R) {
+   ssize_t k = read(R->fd, R->buf + R->len, LINE_LEN-1 - R->len);
+   char   *s, *nl;
+   if ( k < 0 && errno == EINTR )
+      return 1;
+   if ( k > 0 )
+      R->len += k;
+   R->buf[R->len] = '\0';
+   s = R->buf;
+   while ( (nl = strchr(s, '\n')) != NULL ) {
+      *nl = '\0';
+      parse_line(R, s);
+      s = nl+1;
+   }
+   /// A line longer than the buffer (e.g. the certificate) is dropped
+   if ( s == R->buf && R->len == LINE_LEN-1 )
+      s = R->buf + R->len;
+   R->len -= s - R->buf;
+   memmove(R->buf, s, R->len);
+   if ( k <= 0 && R->len > 0 ) {
+      R->buf[R->len] = '\0';
+      parse_line(R, R->buf);
+      R->len = 0;
+   }
+   return k > 0;
+}
+
+static void end_run(run_t* R) {
+   int st, fst;
+   close(R->fd);
+   waitpid(R->pid, &st, 0);
+   waitpid(R->feeder, &fst, 0);
+   R->time = now() - R->start;
+   if ( !R->timeout && (!WIFEXITED(st) || WEXITSTATUS(st) == 127 || !WIFEXITED(fst) || WEXITSTATUS(fst) != 0) )
+      R->error = 1;
+   if ( R->nodes < 0 )
+      R->nodes = R->step_nodes;
+}
+
+static void print_run(const run_t* R) {
+   int i;
+   printf("{\"instance\":\"%s\",\"config\":\"%s\",\"status\":\"%s\",\"time\":%.3f,"
+          "\"nodes\":%ld,\"lb\":%d,\"ub\":%d,\"trajectory\":[",
+          R->inst, conf_line[R->conf],
+          R->error ? "error" : R->timeout ? "timeout" : R->optimal ? "optimal" : "stopped",
+          R->time, R->nodes, R->lb, R->ub);
+   for ( i = 0; i < R->ntraj; ++i )
+      printf("%s[%.3f,%d,%d]", i ? "," : "", R->traj[3*i], (int)R->traj[3*i+1], (int)R->traj[3*i+2]);
+   printf("]}\n");
+   fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+   int       jobs = 1, ninst = 0, nrun, next = 0, running = 0, i, j;
+   double    limit = 600;
+   char    **inst = (char**) malloc(argc*sizeof(char*));
+   run_t    *R;
+   run_t   **slot;
+   struct pollfd *pfd;
+
+   for ( i = 1; i < argc; ++i ) {
+      if ( strcmp(argv[i], "-j") == 0 && i+1 < argc )
+         jobs = atoi(argv[++i]);
+      else if ( strcmp(argv[i], "-t") == 0 && i+1 < argc )
+         limit = atof(argv[++i]);
+      else if ( strcmp(argv[i], "-c") == 0 && i+1 < argc && nconf < MAX_CONF )
+         parse_conf(argv[++i]);
+      else
+         inst[ninst++] = argv[i];
+   }
+   if ( nconf == 0 || ninst == 0 ) {
+      fprintf(stderr, "\nusage:  $ ./batch [-j jobs] [-t seconds] -c \"<solver> <args>\" [-c ...] <instances>\n");
+      fprintf(stderr, "  e.g. ./batch -j 4 -t 300 -c \"./dsatur 1\" -c \"./GeCol 7 14\" *.col *.mps.gz\n\n");
+      exit(EXIT_FAILURE);
+   }
+   if ( jobs < 1 )
+      jobs = 1;
+   /// A solver that exits early must not kill the feeder (or the runner)
+   signal(SIGPIPE, SIG_IGN);
+
+   nrun = ninst*nconf;
+   R    = (run_t*) calloc(nrun, sizeof(run_t));
+   slot = (run_t**) malloc(jobs*sizeof(run_t*));
+   pfd  = (struct pollfd*) malloc(jobs*sizeof(struct pollfd));
+   for ( i = 0; i < nrun; ++i ) {
+      R[i].inst  = inst[i / nconf];
+      R[i].conf  = i % nconf;
+      R[i].lb    = 0;
+      R[i].ub    = -1;
+      R[i].nodes = -1;
+   }
+
+   while ( next < nrun || running > 0 ) {
+      while ( running < jobs && next < nrun ) {
+         start_run(&R[next]);
+         slot[running++] = &R[next++];
+      }
+      for ( j = 0; j < running; ++j ) {
+         pfd[j].fd = slot[j]->fd;
+         pfd[j].events = POLLIN;
+      }
+      poll(pfd, running, 100);
+      for ( j = 0; j < running; ) {
+         run_t* S = slot[j];
+         if ( (pfd[j].revents & (POLLIN | POLLHUP | POLLERR)) && !read_run(S) ) {
+            end_run(S);
+            print_run(S);
+            slot[j] = slot[--running];
+            pfd[j] = pfd[running];
+            continue;
+         }
+         if ( !S->timeout && now() - S->start > limit ) {
+            S->timeout = 1;
+            kill(S->pid, SIGKILL);
+            kill(S->feeder, SIGKILL);
+         }
+         ++j;
+      }
+   }
+
+   fprintf(stderr, "%-24s %-24s %8s %4s %4s %10s %12s\n", "Instance", "Config", "Status", "LB", "UB", "Time", "Nodes");
+   for ( i = 0; i < nrun; ++i )
+      fprintf(stderr, "%-24s %-24s %8s %4d %4d %10.2f %12ld\n",
+            strrchr(R[i].inst, '/') ? strrchr(R[i].inst, '/')+1 : R[i].inst, conf_line[R[i].conf],
+            R[i].error ? "error" : R[i].timeout ? "timeout" : R[i].optimal ? "optimal" : "stopped",
+            R[i].lb, R[i].ub, R[i].time, R[i].nodes);
+
+   for ( i = 0; i < nrun; ++i )
+      free(R[i].traj);
+   for ( i = 0; i < nconf; ++i )
+      free(conf_line[i]);
+   free(pfd);
+   free(slot);
+   free(R);
+   free(inst);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Bitset kernels on 64-bit words, used to store adjacency matrices
+ *  and candidate sets of vertices. The AND kernels use AVX2 whenever
+ *  the compiler enables it (e.g., with -march=native).
+ *
+ *  Iterate over the elements of a bitset 'b' of 'w' words as:
+ *
+ *     for ( v = bs_next(b, w, 0); v >= 0; v = bs_next(b, w, v+1) )
+ */
+
+#ifndef _BITSET_H_
+#define _BITSET_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+typedef uint64_t word_t;
+
+/// Number of words to store a bitset of 'n' elements
+#define BS_WORDS(n)        (((n)+63) >> 6)
+
+#define BS_CONTAINS(b,i)   (((b)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BS_ADD(b,i)        ((b)[(i) >> 6] |= ((word_t)1 << ((i) & 63)))
+#define BS_DEL(b,i)        ((b)[(i) >> 6] &= ~((word_t)1 << ((i) & 63)))
+
+static inline void bs_clear(word_t* a, int w) {
+   memset(a, 0, w*sizeof(word_t));
+}
+
+static inline void bs_copy(word_t* r, const word_t* a, int w) {
+   memcpy(r, a, w*sizeof(word_t));
+}
+
+/// Number of elements in 'a'
+static inline int bs_count(const word_t* a, int w) {
+   int i, c = 0;
+   for ( i = 0; i < w; ++i )
+      c += __builtin_popcountll(a[i]);
+   return c;
+}
+
+/// Number of elements in 'a & b'
+static inline int bs_and_count(const word_t* a, const word_t* b, int w) {
+   int i = 0, c = 0;
+#ifdef __AVX2__
+   for ( ; i+4 <= w; i += 4 ) {
+      __m256i x = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a+i)),
+                                   _mm256_loadu_si256((const __m256i*)(b+i)));
+      c += __builtin_popcountll(_mm256_extract_epi64(x,0)) + __builtin_popcountll(_mm256_extract_epi64(x,1))
+         + __builtin_popcountll(_mm256_extract_epi64(x,2)) + __builtin_popcountll(_mm256_extract_epi64(x,3));
+   }
+#endif
+   for ( ; i < w; ++i )
+      c += __builtin_popcountll(a[i] & b[i]);
+   return c;
+}
+
+/// r = a & b
+static inline void bs_and(word_t* r, const word_t* a, const word_t* b, int w) {
+   int i = 0;
+#ifdef __AVX2__
+   for ( ; i+4 <= w; i += 4 )
+      _mm256_storeu_si256((__m256i*)(r+i),
+            _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a+i)),
+                             _mm256_loadu_si256((const __m256i*)(b+i))));
+#endif
+   for ( ; i < w; ++i )
+      r[i] = a[i] & b[i];
+}
+
+/// r = a & ~b
+static inline void bs_andnot(word_t* r, const word_t* a, const word_t* b, int w) {
+   int i = 0;
+#ifdef __AVX2__
+   for ( ; i+4 <= w; i += 4 )
+      _mm256_storeu_si256((__m256i*)(r+i),
+            _mm256_andnot_si256(_mm256_loadu_si256((const __m256i*)(b+i)),
+                                _mm256_loadu_si256((const __m256i*)(a+i))));
+#endif
+   for ( ; i < w; ++i )
+      r[i] = a[i] & ~b[i];
+}
+
+/// True if 'a' is a subset of 'b'
+static inline int bs_subset(const word_t* a, const word_t* b, int w) {
+   int i;
+   for ( i = 0; i < w; ++i )
+      if ( a[i] & ~b[i] )
+         return 0;
+   return 1;
+}
+
+static inline int bs_empty(const word_t* a, int w) {
+   int i;
+   for ( i = 0; i < w; ++i )
+      if ( a[i] )
+         return 0;
+   return 1;
+}
+
+/// Smallest element of 'a' greater or equal to 'i', or -1
+static inline int bs_next(const word_t* a, int w, int i) {
+   int    k = i >> 6;
+   word_t x;
+   if ( k >= w )
+      return -1;
+   x = a[k] & (~(word_t)0 << (i & 63));
+   while ( !x ) {
+      if ( ++k == w )
+         return -1;
+      x = a[k];
+   }
+   return (k << 6) + __builtin_ctzll(x);
+}
+
+/// Largest element of 'a', or -1
+static inline int bs_last(const word_t* a, int w) {
+   int k;
+   for ( k = w-1; k >= 0; --k )
+      if ( a[k] )
+         return (k << 6) + 63 - __builtin_clzll(a[k]);
+   return -1;
+}
+
+#endif /* _BITSET_H_ */
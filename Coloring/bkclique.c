@@ -0,0 +1,189 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Enumeration of the maximal cliques by Bron-Kerbosch (see bkclique.h)
+ */
+
+#include <stdlib.h>
+
+#include "bkclique.h"
+
+typedef struct {
+   int          n, w;
+   word_t* const* adj;
+   int         *R;        /* current clique */
+   word_t      *buf;      /* P, X and the branching set of every level */
+   int          stop;
+   bk_report_t  report;
+   void        *data;
+   bk_stats_t  *st;
+} bk_t;
+
+/// Degeneracy ordering (Batagelj-Zaversnik bucket peeling): order[i] is
+/// the i-th vertex removed, and the degeneracy is returned
+static int bk_degeneracy(int n, int w, word_t* const* adj, int* order) {
+   int  i, v, u, d, md = 0, k = 0;
+   int* deg  = (int*) malloc(n*sizeof(int));
+   int* pos  = (int*) malloc(n*sizeof(int));
+   int* vert = (int*) malloc(n*sizeof(int));
+   int* bin;
+   for ( v = 0; v < n; ++v ) {
+      deg[v] = bs_count(adj[v], w);
+      if ( deg[v] > md )
+         md = deg[v];
+   }
+   bin = (int*) calloc(md+1, sizeof(int));
+   for ( v = 0; v < n; ++v )
+      bin[deg[v]]++;
+   for ( d = 0, i = 0; d <= md; ++d ) {
+      int c = bin[d];
+      bin[d] = i;
+      i += c;
+   }
+   for ( v = 0; v < n; ++v ) {
+      pos[v] = bin[deg[v]];
+      vert[pos[v]] = v;
+      bin[deg[v]]++;
+   }
+   for ( d = md; d > 0; --d )
+      bin[d] = bin[d-1];
+   bin[0] = 0;
+   for ( i = 0; i < n; ++i ) {
+      v = vert[i];
+      order[i] = v;
+      if ( deg[v] > k )
+         k = deg[v];
+      for ( u = bs_next(adj[v], w, 0); u >= 0; u = bs_next(adj[v], w, u+1) )
+         if ( deg[u] > deg[v] ) {
+            /// Move u to the front of its bin, then decrease its degree
+            int du = deg[u], pu = pos[u], pw = bin[du], x = vert[pw];
+            if ( u != x ) {
+               pos[u] = pw; vert[pw] = u;
+               pos[x] = pu; vert[pu] = x;
+            }
+            bin[du]++;
+            deg[u]--;
+         }
+   }
+   free(bin);
+   free(vert);
+   free(pos);
+   free(deg);
+   return k;
+}
+
+static void bk_output(bk_t* B, int d) {
+   bk_stats_t* st = B->st;
+   if ( d < st->min_size )
+      return;
+   st->cliques++;
+   if ( !B->report(B->R, d, B->data) || (st->max_cliques > 0 && st->cliques >= st->max_cliques) )
+      B->stop = 1;
+}
+
+/// Maximal cliques containing R[0..d), the vertices of P and none of X:
+/// P and X are the buffers of level d
+static void bk_expand(bk_t* B, int d) {
+   int         w = B->w, u, v = -1, best = -1, c;
+   word_t*     P = B->buf + (size_t)3*w*d;
+   word_t*     X = P + w;
+   word_t*     Q = X + w;
+   word_t*     P1 = Q + w;
+   word_t*     X1 = P1 + w;
+   bk_stats_t* st = B->st;
+
+   if ( ++st->nodes == st->max_nodes )
+      B->stop = 1;
+   if ( st->max_size > 0 && d >= st->max_size ) {   /// Not extended
+      st->complete = 0;
+      bk_output(B, d);
+      return;
+   }
+   if ( bs_empty(P, w) ) {
+      if ( bs_empty(X, w) )
+         bk_output(B, d);
+      return;
+   }
+   if ( d + bs_count(P, w) < st->min_size )
+      return;
+   /// Pivot: the vertex of P u X with the most neighbors in P
+   for ( u = bs_next(P, w, 0); u >= 0; u = bs_next(P, w, u+1) )
+      if ( (c = bs_and_count(P, B->adj[u], w)) > best ) {
+         best = c;
+         v = u;
+      }
+   for ( u = bs_next(X, w, 0); u >= 0; u = bs_next(X, w, u+1) )
+      if ( (c = bs_and_count(P, B->adj[u], w)) > best ) {
+         best = c;
+         v = u;
+      }
+   bs_andnot(Q, P, B->adj[v], w);
+   for ( u = bs_next(Q, w, 0); u >= 0 && !B->stop; u = bs_next(Q, w, u+1) ) {
+      B->R[d] = u;
+      bs_and(P1, P, B->adj[u], w);
+      bs_and(X1, X, B->adj[u], w);
+      bk_expand(B, d+1);
+      BS_DEL(P, u);
+      BS_ADD(X, u);
+      if ( d + bs_count(P, w) < st->min_size )
+         break;
+   }
+}
+
+long bk_maximal_cliques(int n, word_t* const* adj, bk_report_t report, void* data,
+                        bk_stats_t* st) {
+   bk_t        B;
+   bk_stats_t  defaults = { 0, 0, 0, 0, 0, 0, 0, 0 };
+   int         w = BS_WORDS(n), i, v, k;
+   int*        order;
+   word_t*     later;
+
+   if ( st == NULL )
+      st = &defaults;
+   st->cliques = 0;
+   st->nodes = 0;
+   st->complete = 1;
+   if ( n == 0 ) {
+      st->degeneracy = 0;
+      return 0;
+   }
+   order = (int*) malloc(n*sizeof(int));
+   k = bk_degeneracy(n, w, adj, order);
+   st->degeneracy = k;
+
+   B.n = n;
+   B.w = w;
+   B.adj = adj;
+   B.R = (int*) malloc((k+2)*sizeof(int));
+   /// The depth of the search is at most k+1: P and X of every level, and
+   /// the branching set Q
+   B.buf = (word_t*) malloc((size_t)3*w*(k+3)*sizeof(word_t));
+   B.stop = 0;
+   B.report = report;
+   B.data = data;
+   B.st = st;
+
+   /// Outer loop in degeneracy order: the neighbors of v removed after v
+   /// are the candidates, those removed before it are excluded
+   later = (word_t*) malloc(w*sizeof(word_t));
+   bs_clear(later, w);
+   for ( v = 0; v < n; ++v )
+      BS_ADD(later, v);
+   for ( i = 0; i < n && !B.stop; ++i ) {
+      v = order[i];
+      BS_DEL(later, v);
+      B.R[0] = v;
+      bs_and(B.buf + 3*w, adj[v], later, w);
+      bs_andnot(B.buf + 4*w, adj[v], later, w);
+      bk_expand(&B, 1);
+   }
+   if ( B.stop )
+      st->complete = 0;
+
+   free(later);
+   free(B.buf);
+   free(B.R);
+   free(order);
+   return st->cliques;
+}
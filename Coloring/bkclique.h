@@ -0,0 +1,53 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Enumeration of the maximal cliques of a graph by Bron-Kerbosch, with the
+ *  pivot of Tomita, Tanaka and Takahashi (the vertex of P u X with the most
+ *  neighbors in P) and the outer loop in degeneracy order (Eppstein, Loffler
+ *  and Strash), so that the sets P and X of the top level have at most
+ *  'degeneracy' vertices. P and X are bitsets, and the buffers of every
+ *  level are allocated once. The cliques are streamed to a callback, and
+ *  the enumeration can be capped on the number of cliques, on the nodes,
+ *  and on the size of the cliques. The library is written in C and can be
+ *  used from C++.
+ */
+
+#ifndef _BKCLIQUE_H_
+#define _BKCLIQUE_H_
+
+#include "bitset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Called for every clique found, with its vertices clique[0..size):
+/// returns 0 to stop the enumeration
+typedef int (*bk_report_t)(const int* clique, int size, void* data);
+
+typedef struct {
+   long   max_cliques;  /* stop after reporting these cliques (0 for no limit) */
+   long   max_nodes;    /* stop after these search nodes (0 for no limit) */
+   int    min_size;     /* report only the cliques of at least min_size vertices;
+                           the callback may raise it, to prune the search */
+   int    max_size;     /* a clique of max_size vertices is reported without
+                           being extended (0 for no limit) */
+   long   cliques;      /* cliques reported */
+   long   nodes;        /* search nodes visited */
+   int    degeneracy;   /* degeneracy of the graph */
+   int    complete;     /* 1 if every maximal clique (within the sizes) was reported */
+} bk_stats_t;
+
+/// Maximal cliques of the graph with 'n' vertices and adjacency rows 'adj'
+/// (bitsets of BS_WORDS(n) words, no loops), reported to 'report'. Returns
+/// the number of cliques reported. 'st' may be NULL; otherwise the limits
+/// are read, and the rest is written
+long bk_maximal_cliques(int n, word_t* const* adj, bk_report_t report, void* data,
+                        bk_stats_t* st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BKCLIQUE_H_ */
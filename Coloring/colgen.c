@@ -0,0 +1,410 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Column generation lower bound for graph coloring (see colgen.h)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "colgen.h"
+#include "maxclique.h"
+
+#define CG_EPS     1e-9    /* tolerance on pivots and reduced costs */
+#define CG_PRICE   1e-6    /* a column enters if its weight is above 1+CG_PRICE */
+#define CG_ROUND   1e-6    /* tolerance of the rounding up of the bounds */
+
+/// Master LP: row v is "vertex v is covered", the variables are the columns
+/// of the pool (cost 1) and the surplus of each row (cost 0). basis[i] is
+/// the basic variable of position i: a column c >= 0, or the surplus of
+/// vertex v as -(v+1)
+typedef struct {
+   int       n, w;
+   word_t  *const *adj;
+   word_t   *pool;       /* columns, w words each */
+   int       ncol, maxcol;
+   char     *basic;      /* basic[c] = 1 if column c is basic */
+   int      *basis;
+   double   *Binv;       /* dense inverse of the basis, row major */
+   double   *b;          /* right hand side, perturbed */
+   double   *xB;
+   double   *pi;         /* dual values */
+   double   *d;          /* entering column in the current basis */
+} cg_t;
+
+typedef struct {
+   double   w;
+   int      v;
+} cg_item_t;
+
+static int cg_cmp(const void* a, const void* b) {
+   double wa = ((const cg_item_t*)a)->w, wb = ((const cg_item_t*)b)->w;
+   return (wa < wb) - (wa > wb);
+}
+
+static word_t* cg_new_column(cg_t* M) {
+   if ( M->ncol == M->maxcol ) {
+      M->maxcol *= 2;
+      M->pool  = (word_t*) realloc(M->pool, (size_t)M->maxcol*M->w*sizeof(word_t));
+      M->basic = (char*) realloc(M->basic, M->maxcol*sizeof(char));
+   }
+   M->basic[M->ncol] = 0;
+   bs_clear(M->pool + (size_t)M->ncol*M->w, M->w);
+   return M->pool + (size_t)(M->ncol++)*M->w;
+}
+
+/// Invert the basis from scratch (Gauss-Jordan with partial pivoting) and
+/// recompute the basic solution: returns 0 if the basis is singular
+static int cg_invert(cg_t* M) {
+   int      n = M->n, i, j, r, p, v;
+   double  *B = (double*) calloc((size_t)n*n, sizeof(double));
+   double  *I = M->Binv, t, *rowp, *rowr;
+
+   for ( j = 0; j < n; ++j ) {
+      if ( M->basis[j] >= 0 ) {
+         const word_t* col = M->pool + (size_t)M->basis[j]*M->w;
+         for ( v = bs_next(col, M->w, 0); v >= 0; v = bs_next(col, M->w, v+1) )
+            B[(size_t)v*n + j] = 1;
+      } else
+         B[(size_t)(-M->basis[j]-1)*n + j] = -1;
+   }
+   memset(I, 0, (size_t)n*n*sizeof(double));
+   for ( i = 0; i < n; ++i )
+      I[(size_t)i*n + i] = 1;
+   for ( j = 0; j < n; ++j ) {
+      p = j;
+      for ( r = j+1; r < n; ++r )
+         if ( fabs(B[(size_t)r*n + j]) > fabs(B[(size_t)p*n + j]) )
+            p = r;
+      if ( fabs(B[(size_t)p*n + j]) < CG_EPS ) {
+         free(B);
+         return 0;
+      }
+      if ( p != j )
+         for ( i = 0; i < n; ++i ) {
+            t = B[(size_t)p*n + i]; B[(size_t)p*n + i] = B[(size_t)j*n + i]; B[(size_t)j*n + i] = t;
+            t = I[(size_t)p*n + i]; I[(size_t)p*n + i] = I[(size_t)j*n + i]; I[(size_t)j*n + i] = t;
+         }
+      rowp = B + (size_t)j*n;
+      rowr = I + (size_t)j*n;
+      t = 1/rowp[j];
+      for ( i = 0; i < n; ++i ) {
+         rowp[i] *= t;
+         rowr[i] *= t;
+      }
+      for ( r = 0; r < n; ++r )
+         if ( r != j && B[(size_t)r*n + j] != 0 ) {
+            t = B[(size_t)r*n + j];
+            for ( i = 0; i < n; ++i ) {
+               B[(size_t)r*n + i] -= t*rowp[i];
+               I[(size_t)r*n + i] -= t*rowr[i];
+            }
+         }
+   }
+   /// Row j of B^-1 gives basic variable j, since the rows of B were swapped
+   /// as the rows of I
+   for ( i = 0; i < n; ++i ) {
+      M->xB[i] = 0;
+      for ( j = 0; j < n; ++j )
+         M->xB[i] += I[(size_t)i*n + j]*M->b[j];
+   }
+   free(B);
+   return 1;
+}
+
+/// Dual values pi = c_B B^-1
+static void cg_duals(cg_t* M) {
+   int n = M->n, i, j;
+   for ( j = 0; j < n; ++j )
+      M->pi[j] = 0;
+   for ( i = 0; i < n; ++i )
+      if ( M->basis[i] >= 0 )
+         for ( j = 0; j < n; ++j )
+            M->pi[j] += M->Binv[(size_t)i*n + j];
+}
+
+/// Weight of column c under the dual values
+static double cg_weight(const cg_t* M, const word_t* col) {
+   double s = 0;
+   int v;
+   for ( v = bs_next(col, M->w, 0); v >= 0; v = bs_next(col, M->w, v+1) )
+      s += M->pi[v];
+   return s;
+}
+
+/// Extend the independent set 'col' to a maximal one, first by the vertices
+/// of positive dual value ('order'), then by all the others
+static void cg_maximal(cg_t* M, word_t* col, const cg_item_t* order, int len) {
+   int i, v;
+   for ( i = 0; i < len+M->n; ++i ) {
+      v = (i < len) ? order[i].v : i-len;
+      if ( !BS_CONTAINS(col, v) && bs_and_count(M->adj[v], col, M->w) == 0 )
+         BS_ADD(col, v);
+   }
+}
+
+/// Pricing: a new column of weight above 1 is added to the pool, and its
+/// index is returned (-1 if none is found). The greedy independent set is
+/// tried first; the exact one gives also '*wmax', the maximum weight of an
+/// independent set under the positive part of the duals (0 if the exact
+/// pricing is not run or stops at the node limit)
+static int cg_price(cg_t* M, cg_stats_t* st, double* wmax) {
+   int          n = M->n, np = 0, i, j, size;
+   cg_item_t   *order = (cg_item_t*) malloc(n*sizeof(cg_item_t));
+   word_t      *col, *rows, **cadj;
+   int         *clique;
+   double      *wt, s = 0;
+   mc_stats_t   mst;
+
+   *wmax = 0;
+   for ( i = 0; i < n; ++i )
+      if ( M->pi[i] > CG_EPS ) {
+         order[np].w = M->pi[i];
+         order[np++].v = i;
+      }
+   qsort(order, np, sizeof(cg_item_t), cg_cmp);
+
+   /// Greedy independent set by decreasing dual value
+   col = cg_new_column(M);
+   for ( i = 0; i < np; ++i ) {
+      int v = order[i].v;
+      if ( bs_and_count(M->adj[v], col, M->w) == 0 ) {
+         BS_ADD(col, v);
+         s += order[i].w;
+      }
+   }
+   if ( s > 1+CG_PRICE ) {
+      cg_maximal(M, col, order, np);
+      free(order);
+      return M->ncol-1;
+   }
+
+   /// Exact: maximum weight clique in the complement of the graph induced
+   /// by the vertices of positive dual value
+   st->pricings++;
+   rows   = (word_t*) calloc((size_t)np*BS_WORDS(np), sizeof(word_t));
+   cadj   = (word_t**) malloc((np+1)*sizeof(word_t*));
+   wt     = (double*) malloc((np+1)*sizeof(double));
+   clique = (int*) malloc((np+1)*sizeof(int));
+   for ( i = 0; i < np; ++i ) {
+      cadj[i] = rows + (size_t)i*BS_WORDS(np);
+      wt[i] = order[i].w;
+      for ( j = 0; j < np; ++j )
+         if ( j != i && !BS_CONTAINS(M->adj[order[i].v], order[j].v) )
+            BS_ADD(cadj[i], j);
+   }
+   mst.max_nodes = st->max_nodes;
+   s = mc_max_weight_clique(np, cadj, wt, clique, &size, &mst);
+   if ( mst.optimal )
+      *wmax = s;
+   bs_clear(col, M->w);
+   for ( i = 0; i < size; ++i )
+      BS_ADD(col, order[clique[i]].v);
+   free(clique);
+   free(wt);
+   free(cadj);
+   free(rows);
+   if ( s > 1+CG_PRICE ) {
+      cg_maximal(M, col, order, np);
+      free(order);
+      return M->ncol-1;
+   }
+   M->ncol--;
+   free(order);
+   return -1;
+}
+
+int cg_lower_bound(int n, word_t* const* adj, const int* color, cg_stats_t* st) {
+   cg_t         M;
+   cg_stats_t   tmp;
+   int          i, j, v, k = 0, r, enter, bound = 0, degenerate = 0, since = 0;
+   int          none = -(n+1);   /* no entering variable: not a surplus */
+   double       z, sum, wmax, best, theta;
+   clock_t      start = clock();
+   int         *rep;
+
+   if ( st == NULL ) {
+      memset(&tmp, 0, sizeof(tmp));
+      st = &tmp;
+   }
+   st->lp = st->lb = 0;
+   st->optimal = 0;
+   st->pivots = 0;
+   st->pricings = 0;
+   st->columns = 0;
+   if ( n <= 0 )
+      return 0;
+
+   M.n = n;
+   M.w = BS_WORDS(n);
+   M.adj = adj;
+   M.ncol = 0;
+   M.maxcol = 64;
+   M.pool  = (word_t*) malloc((size_t)M.maxcol*M.w*sizeof(word_t));
+   M.basic = (char*) malloc(M.maxcol*sizeof(char));
+   M.basis = (int*) malloc(n*sizeof(int));
+   M.Binv  = (double*) malloc((size_t)n*n*sizeof(double));
+   M.xB    = (double*) malloc(n*sizeof(double));
+   M.pi    = (double*) malloc(n*sizeof(double));
+   M.d     = (double*) malloc(n*sizeof(double));
+   M.b     = (double*) malloc(n*sizeof(double));
+
+   /// The master is very degenerate: the right hand side is perturbed, and
+   /// the bounds are computed only from the duals, which are dual feasible
+   /// also for the original right hand side
+   for ( v = 0; v < n; ++v )
+      M.b[v] = 1 + 1e-6*(1 + (v*7919) % 97);
+
+   /// Initial basis: the color classes, each one basic on the row of its
+   /// vertex with the largest right hand side, and the surplus of all the
+   /// other rows, which is then b[rep]-b[v] >= 0: the basis is primal feasible
+   for ( v = 0; v < n; ++v )
+      if ( color[v]+1 > k )
+         k = color[v]+1;
+   rep = (int*) malloc(k*sizeof(int));
+   for ( i = 0; i < k; ++i ) {
+      cg_new_column(&M);
+      rep[i] = -1;
+   }
+   for ( v = 0; v < n; ++v ) {
+      BS_ADD(M.pool + (size_t)color[v]*M.w, v);
+      if ( rep[color[v]] < 0 || M.b[v] > M.b[rep[color[v]]] )
+         rep[color[v]] = v;
+      M.basis[v] = -(v+1);
+   }
+   for ( i = 0; i < k; ++i )
+      if ( rep[i] >= 0 ) {
+         M.basis[rep[i]] = i;
+         M.basic[i] = 1;
+      }
+   free(rep);
+   cg_invert(&M);
+
+   while ( 1 ) {
+      if ( st->time_limit > 0 && (double)(clock()-start)/CLOCKS_PER_SEC > st->time_limit )
+         break;
+      /// Reinversion, for numerical stability
+      if ( ++since > n ) {
+         if ( !cg_invert(&M) )
+            break;
+         since = 0;
+      }
+      cg_duals(&M);
+      z = 0;
+      for ( i = 0; i < n; ++i )
+         if ( M.basis[i] >= 0 )
+            z += M.xB[i];
+      st->lp = z;
+
+      /// Entering variable: Dantzig's rule, or Bland's after a long run of
+      /// degenerate pivots (the master is highly degenerate)
+      enter = none;
+      best = -CG_EPS;
+      for ( v = 0; v < n && (enter == none || degenerate < 50); ++v )
+         if ( M.pi[v] < best ) {
+            best = M.pi[v];
+            enter = -(v+1);
+         }
+      for ( j = 0; j < M.ncol && (enter == none || degenerate < 50); ++j )
+         if ( !M.basic[j] ) {
+            double rc = 1 - cg_weight(&M, M.pool + (size_t)j*M.w);
+            if ( rc < best ) {
+               best = rc;
+               enter = j;
+            }
+         }
+      if ( enter == none ) {
+         enter = cg_price(&M, st, &wmax);
+         if ( wmax > 0 ) {
+            /// Farley bound with the positive part of the duals
+            sum = 0;
+            for ( v = 0; v < n; ++v )
+               if ( M.pi[v] > 0 )
+                  sum += M.pi[v];
+            if ( sum/(wmax > 1 ? wmax : 1) > st->lb )
+               st->lb = sum/(wmax > 1 ? wmax : 1);
+         }
+         if ( enter < 0 ) {
+            /// The LP is optimal if the exact pricing was complete, and then
+            /// the Farley bound is the LP optimum
+            st->optimal = (wmax > 0);
+            break;
+         }
+      }
+      bound = (int)ceil(st->lb - CG_ROUND);
+      if ( bound >= k || bound >= (int)ceil(z - CG_ROUND) )
+         break;
+
+      /// Entering column in the current basis
+      for ( i = 0; i < n; ++i )
+         M.d[i] = 0;
+      if ( enter >= 0 ) {
+         const word_t* col = M.pool + (size_t)enter*M.w;
+         for ( v = bs_next(col, M.w, 0); v >= 0; v = bs_next(col, M.w, v+1) )
+            for ( i = 0; i < n; ++i )
+               M.d[i] += M.Binv[(size_t)i*n + v];
+      } else
+         for ( i = 0; i < n; ++i )
+            M.d[i] = -M.Binv[(size_t)i*n + (-enter-1)];
+
+      /// Ratio test: ties by the largest pivot, or by the smallest variable
+      /// (surplus first) with Bland's rule
+      r = -1;
+      theta = 0;
+      for ( i = 0; i < n; ++i )
+         if ( M.d[i] > CG_EPS ) {
+            double t = M.xB[i]/M.d[i];
+            if ( r < 0 || t < theta - CG_EPS ) {
+               r = i;
+               theta = t;
+            } else if ( t < theta + CG_EPS ) {
+               if ( degenerate < 50 ? M.d[i] > M.d[r]
+                     : (M.basis[i] < 0 ? -M.basis[i] : n+M.basis[i]) < (M.basis[r] < 0 ? -M.basis[r] : n+M.basis[r]) )
+                  r = i;
+            }
+         }
+      if ( r < 0 )   /// Unbounded: impossible, since the costs are >= 0
+         break;
+      degenerate = (theta < CG_EPS) ? degenerate+1 : 0;
+
+      /// Pivot
+      {
+         double  p = M.d[r];
+         double *row = M.Binv + (size_t)r*n;
+         for ( j = 0; j < n; ++j )
+            row[j] /= p;
+         M.xB[r] /= p;
+         for ( i = 0; i < n; ++i )
+            if ( i != r && M.d[i] != 0 ) {
+               double  t = M.d[i];
+               double *rowi = M.Binv + (size_t)i*n;
+               for ( j = 0; j < n; ++j )
+                  rowi[j] -= t*row[j];
+               M.xB[i] -= t*M.xB[r];
+               if ( M.xB[i] < 0 && M.xB[i] > -CG_EPS )
+                  M.xB[i] = 0;
+            }
+      }
+      if ( M.basis[r] >= 0 )
+         M.basic[M.basis[r]] = 0;
+      M.basis[r] = enter;
+      if ( enter >= 0 )
+         M.basic[enter] = 1;
+      st->pivots++;
+   }
+
+   st->columns = M.ncol;
+   bound = (int)ceil(st->lb - CG_ROUND);
+   free(M.b);
+   free(M.d);
+   free(M.pi);
+   free(M.xB);
+   free(M.Binv);
+   free(M.basis);
+   free(M.basic);
+   free(M.pool);
+   return bound;
+}
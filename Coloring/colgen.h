@@ -0,0 +1,53 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Lower bound on the chromatic number by column generation (Mehrotra and
+ *  Trick, "A column generation approach for graph coloring", 1996): the
+ *  master LP is min sum_S x_S s.t. every vertex is covered by the chosen
+ *  independent sets S. The master is solved by a small revised primal
+ *  simplex with a dense basis inverse, starting from the color classes of
+ *  a coloring, with the right hand side slightly perturbed against
+ *  degeneracy: each class is basic on the row with its largest right hand
+ *  side, so that all the surplus are nonnegative and no phase one is needed. The columns are bitsets stored in
+ *  one contiguous pool. Pricing is a maximum weight independent set with
+ *  the dual values as weights: a greedy one first, and then the exact one,
+ *  as a maximum weight clique of the complement graph (see maxclique.h).
+ *  Every exact pricing gives the Farley bound sum(pi)/max_weight, so the
+ *  search stops as soon as the rounded bound cannot improve. The library
+ *  is written in C and can be used from C++.
+ */
+
+#ifndef _COLGEN_H_
+#define _COLGEN_H_
+
+#include "bitset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+   double   time_limit;  /* seconds of CPU time (0 for no limit) */
+   long     max_nodes;   /* nodes of each exact pricing (0 for no limit) */
+   double   lp;          /* value of the last master LP (written) */
+   double   lb;          /* best Farley bound, or the LP optimum (written) */
+   int      optimal;     /* 1 if the master LP is solved to optimality */
+   long     pivots;      /* simplex pivots */
+   int      columns;     /* columns in the pool */
+   int      pricings;    /* exact pricings */
+} cg_stats_t;
+
+/// Lower bound on the chromatic number of the graph with 'n' vertices and
+/// adjacency rows 'adj' (bitsets of BS_WORDS(n) words, no loops), i.e. the
+/// rounded up value of st->lb. 'color' is a coloring with colors in
+/// 0..k-1, whose classes are the first columns; the search stops if the
+/// bound reaches k. 'st' may be NULL; otherwise the limits are read, and
+/// the rest is written
+int cg_lower_bound(int n, word_t* const* adj, const int* color, cg_stats_t* st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COLGEN_H_ */
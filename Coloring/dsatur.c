@@ -43,256 +43,145 @@ For more information on this code, see Anuj Mehrotra and Michael A. Trick,
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/times.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "cliquer.h"
 #include "set.h"
 #include "graph.h"
 #include "reorder.h"
 
+#include "bitset.h"
+#include "maxclique.h"
+#include "tabucol.h"
+#include "colgen.h"
+#include "bkclique.h"
+
 #define MAX_RAND (2.0*(1 << 30))
-#define MAX_NODE 10000 // original: 600
 //#define TRUE 1
 //#define FALSE 0
 #define INF 100000.0
 
-struct tms buffer;			/* structure for timing              */
-int current_time,start_time;
+__thread struct tms buffer;	/* structure for timing              */
+__thread int current_time;
+int start_time;
 double utime;
 
-int adj[MAX_NODE][MAX_NODE];
-int BestColoring;
+/* Shared by all the search threads, and read-only during the search
+   (except BestColoring, which is lowered with update_best) */
+char *arena;
+word_t **adj;        /* adjacency matrix as bitsets */
+int num_word;        /* words per bitset of num_node bits */
+volatile int BestColoring;
 int num_node;
-int ColorClass[MAX_NODE];
-int prob_count;
-int Order[MAX_NODE];
-int Handled[MAX_NODE];
-int ColorAdj[MAX_NODE][MAX_NODE];
-int ColorCount[MAX_NODE];
+int num_color;       /* colors are in [1, maxdeg+1]: see alloc_state */
 int lb;
-int num_prob,max_prob;
-
-
-int best_clique;
-
-
-int greedy_clique(valid,clique)
-   int *valid,*clique;
-
+int root_place;      /* vertices colored before the search (the clique) */
+int *RootOrder;      /* ... and their order */
+long prob_total;     /* subproblems of the finished search threads */
+long prune_total;    /* ... and subtrees pruned by their lower_bound */
+pthread_mutex_t print_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The state of a search, one copy per thread (see alloc_state) */
+__thread char *state_arena;
+__thread int *ColorClass;
+__thread long prob_count;
+__thread long prune_count;   /* subtrees pruned by lower_bound */
+__thread int *Order;
+__thread word_t *Uncolored; /* bitset of the vertices not colored yet */
+__thread int *Trail;       /* saturation changes of each AssignColor */
+__thread int TrailTop;
+__thread word_t *Cand;     /* scratch bitset of lower_bound */
+__thread int **ColorAdj;
+__thread int *ColorCount;
+
+/* Buckets of the uncolored vertices keyed on saturation degree:
+   SatSet[s] is the bitset of the uncolored vertices v with ColorCount[v]=s,
+   and SatTop is an upper bound on the largest nonempty bucket. A vertex
+   changes bucket only when its saturation changes, and the secondary key
+   (uncolored degree) is resolved by scanning the top bucket only. */
+__thread word_t **SatSet;
+__thread int *SatSize;
+__thread int SatTop;
+
+/* Lower the shared upper bound to val: TRUE if val is a new best. The
+   search reads BestColoring without locking: the bound only decreases, and
+   a stale value only delays pruning */
+int update_best(val)
+   int val;
 {
-   int i,j,k;
-   int max;
-   int place,done;
-   int *order;
-   int weight[MAX_NODE];
-
-   for (i=0;i<num_node;i++) clique[i] = 0;
-   order = (int *)calloc(num_node+1,sizeof(int));
-   place = 0;
-   for (i=0;i<num_node;i++) {
-      if (valid[i]) {
-         order[place] = i;
-         place++;
-      }
-   }
-   for (i=0;i<num_node;i++)
-      weight[i] = 0;
-   for (i=0;i<num_node;i++) 
-   {
-      if (!valid[i]) continue;
-      for (j=0;j<num_node;j++) 
-      {
-         if (!valid[j]) continue;
-         if (adj[i][j]) weight[i]++;
-      }
-   }
-
-
-   done = FALSE;
-   while (!done) {
-      done = TRUE;
-      for (i=0;i<place-1;i++) {
-         j = order[i];
-         k = order[i+1];
-         if (weight[j] < weight[k]) {
-            order[i] = k;
-            order[i+1] = j;
-            done = FALSE;
-         }
-      }
-   }
-
-
-   clique[order[0]] = TRUE;
-   for (i=1;i<place;i++) {
-      j = order[i];
-      for (k=0;k<i;k++) {
-         if (clique[order[k]] && !adj[j][order[k]]) break;
-      }
-      if (k==i) {
-         clique[j] = TRUE;
-      }
-      else clique[j] = FALSE;
-
-   }
-   max = 0;
-   for (i=0;i<place;i++) 
-      if (clique[order[i]]) max ++;
-
-   free(order);
-   /*  printf("Clique found of size %d\n",max);*/
+   int old;
 
-   return max;
+   while ((old = __atomic_load_n(&BestColoring,__ATOMIC_RELAXED)) > val)
+      if (__sync_bool_compare_and_swap(&BestColoring,old,val)) return TRUE;
+   return FALSE;
 }
 
-/* Target is a goal value:  once a clique is found with value target
-   it is possible to return
-
-   Lower is a bound representing an already found clique:  once it is
-   determined that no clique exists with value better than lower, it
-   is permitted to return with a suboptimal clique.
-
-   Note, to find a clique of value 1, it is not permitted to just set
-   the lower to 1:  the recursion will not work.  Lower represents a
-   value that is the goal for the recursion.
-   */
-
-int max_w_clique(valid,clique,lower,target)
-   int *valid,*clique;
-   int lower,target;
-
 
+void bucket_insert(v)
+   int v;
 {
-   int start,j,k;
-   int incumb,new_weight;
-   int *valid1,*clique1;
-   int *order;
-   int *value;
-   int i,place,finish,done,place1,place2;
-   int total_left;
-
-   /*  printf("entered with lower %d target %d\n",lower,target);*/
-   num_prob++;
-   if (num_prob > max_prob) return -1;
-   for (j=0;j<num_node;j++) clique[j] = 0;
-   total_left = 0;
-   for (i=0;i<num_node;i++)
-      if (valid[i]) total_left ++;
-   if (total_left < lower) {
-      return 0.0;
-   }
-
-   order = (int *)calloc(num_node+1,sizeof(int));
-   value = (int *) calloc(num_node,sizeof(int));
-   incumb = greedy_clique(valid,clique);
-   if (incumb >=target) return incumb;
-   if (incumb > best_clique) {
-      best_clique=incumb;
-      /*    printf("Clique of size %5d found.\n",best_clique);*/
-   }
-   /*  printf("Greedy gave %f\n",incumb);*/
-
-   place = 0;
-   for (i=0;i<num_node;i++) {
-      if (clique[i]) {
-         order[place] = i;
-         total_left --;
-         place++;
-      }
-   }
-   start = place;
-   for (i=0;i<num_node;i++) {
-      if (!clique[i]&&valid[i]) {
-         order[place] = i;
-         place++;
-      }
-   }
-   finish = place;
-   for (place=start;place<finish;place++) {
-      i = order[place];
-      value[i] = 0;
-      for (j=0;j<num_node;j++) {
-         if (valid[j] && adj[i][j]) value[i]++;
-      }
-   }
-
-   done = FALSE;
-   while (!done) {
-      done = TRUE;
-      for (place=start;place<finish-1;place++) {
-         i = order[place];
-         j = order[place+1];
-         if (value[i] < value[j] ) {
-            order[place] = j;
-            order[place+1] = i;
-            done = FALSE;
-         }
-      }
-   }
-   free(value);
-   for (place=start;place<finish;place++) {
-      if (incumb + total_left < lower) {
-         return 0;
-      }
-
-      j = order[place];
-      total_left --;
-
-      if (clique[j]) continue;
-
-      valid1 = (int *)calloc(num_node,sizeof(int));
-      clique1 = (int *)calloc(num_node,sizeof(int));
-      for (place1=0;place1 < num_node;place1++) valid1[place1] = FALSE;
-      for (place1=0;place1<place;place1++) {
-         k = order[place1];
-         if (valid[k] && (adj[j][k])){
-            valid1[k] = TRUE;
-         }
-         else
-            valid1[k] = FALSE;
-      }
-      new_weight = max_w_clique(valid1,clique1,incumb-1,target-1);
-      if (new_weight+1 > incumb)  {
-         /*      printf("Taking new\n");*/
-         incumb = new_weight+1;
-         for (k=0;k<num_node;k++) clique[k] = clique1[k];
-         clique[j] = TRUE;
-         if (incumb > best_clique) {
-            best_clique=incumb;
-            /*	printf("Clique of size %5d found.\n",best_clique);*/
-         }
-      }
+   BS_ADD(SatSet[ColorCount[v]],v);
+   SatSize[ColorCount[v]]++;
+   if (ColorCount[v] > SatTop) SatTop = ColorCount[v];
+}
 
-      /*    else printf("Taking incumb\n");*/
-      free(valid1);
-      free(clique1);
-      if (incumb >=target) break;
-   }
-   free(order);
-   return(incumb);
+void bucket_remove(v)
+   int v;
+{
+   BS_DEL(SatSet[ColorCount[v]],v);
+   SatSize[ColorCount[v]]--;
 }
 
+/* Uncolored vertex of maximum saturation, ties broken by maximum
+   uncolored degree and then by smallest index; -1 if none */
+int bucket_max()
+{
+   int k,place;
+   word_t *b;
+
+   while (SatTop > 0 && SatSize[SatTop]==0) SatTop--;
+   if (SatSize[SatTop]==0) return -1;
+   b = SatSet[SatTop];
+   place = bs_next(b,num_word,0);
+   for (k=bs_next(b,num_word,place+1);k>=0;k=bs_next(b,num_word,k+1))
+      if (ColorAdj[k][0] > ColorAdj[place][0]) place = k;
+   return place;
+}
 
+/* The colored vertices are never selected again before their color is
+   removed, and assignments are undone in LIFO order: hence AssignColor and
+   RemoveColor update only the uncolored neighbours, and the counters of a
+   colored vertex are back to their value once it is uncolored. */
+#define FOR_UNCOLORED_NEIGHBOUR(node,node1,k,word) \
+   for (k=0;k<num_word;k++) \
+      for (word=adj[node][k] & Uncolored[k]; word && ((node1 = (k << 6) + __builtin_ctzll(word)),1); word &= word-1)
 
+/* The uncolored neighbours whose saturation grows are pushed on the trail,
+   followed by their number, so that RemoveColor moves back only them */
 AssignColor(node,color)
    int node,color;
 
 {
-   int node1;
+   int node1,k,top;
+   word_t word;
 
    /*  printf("  %d color +%d\n",node,color);*/
    ColorClass[node] = color;
-   for (node1=0;node1<num_node;node1++) 
+   top = TrailTop;
+   FOR_UNCOLORED_NEIGHBOUR(node,node1,k,word)
    {
-      if (node==node1) continue;
-      if (adj[node][node1]) 
-      {
-         if (ColorAdj[node1][color]==0) ColorCount[node1]++;
-         ColorAdj[node1][color]++;
-         ColorAdj[node1][0]--;
-         if (ColorAdj[node1][0] < 0) printf("ERROR on assign\n");	
+      if (ColorAdj[node1][color]++ == 0) {
+         bucket_remove(node1);
+         ColorCount[node1]++;
+         bucket_insert(node1);
+         Trail[TrailTop++] = node1;
       }
+      ColorAdj[node1][0]--;
+      if (ColorAdj[node1][0] < 0) printf("ERROR on assign\n");	
    }
-
+   Trail[TrailTop] = TrailTop-top;
+   TrailTop++;
 }
 
 
@@ -300,100 +189,59 @@ RemoveColor(node,color)
    int node,color;
 
 {
-   int node1;
+   int node1,k,num;
+   word_t word;
    /*  printf("  %d color -%d\n",node,color);  */
    ColorClass[node] = 0;
-   for (node1=0;node1<num_node;node1++) 
+   FOR_UNCOLORED_NEIGHBOUR(node,node1,k,word)
    {
-      if (node==node1) continue;
-      if (adj[node][node1]) 
-      {
-         ColorAdj[node1][color]--;
-         if (ColorAdj[node1][color]==0) ColorCount[node1]--;
-         if (ColorAdj[node1][color] < 0) printf("ERROR on assign\n");
-         ColorAdj[node1][0]++;
-      }
+      ColorAdj[node1][color]--;
+      if (ColorAdj[node1][color] < 0) printf("ERROR on assign\n");
+      ColorAdj[node1][0]++;
+   }
+   for (num=Trail[--TrailTop];num>0;num--) {
+      node1 = Trail[--TrailTop];
+      bucket_remove(node1);
+      ColorCount[node1]--;
+      bucket_insert(node1);
    }
-
 }
 
-/*int lower_bound(current_color) 
-  int current_color;
-
-  {
-  int i,j,k;
-  int max;
-  int done;
-  int clique[MAX_NODE];
-  int order[MAX_NODE];
-  int weight[MAX_NODE];
-
-  for (i=0;i<num_node;i++) clique[i] = 0;
-  for (i=0;i<num_node;i++) {
-  order[i] = i;
-  weight[i] = ColorAdj[i][0];
-  for (k=1;k<=current_color;k++)
-  if (ColorClass[i] != k) weight[i] +=ColorAdj[i][k];
-  }
-
-  done = FALSE;
-  while (!done) {
-  done = TRUE;
-  for (i=0;i<num_node-1;i++) {
-  j = order[i];
-  k = order[i+1];
-  if (weight[j] < weight[k]) {
-  order[i] = k;
-  order[i+1] = j;
-  done = FALSE;
-  }
-  }
-  }
-  clique[order[0]] = TRUE;
-  printf("Node %d in clique\n",order[0]);
-  for (i=1;i<num_node;i++) {
-  j = order[i];
-  for (k=0;k<i;k++) {
-  if (clique[order[k]]) {
-  if (!adj[j][order[k]]) 
-  {
-  if ((ColorClass[order[k]]==0) || (ColorClass[j]==0) ||(ColorClass[order[k]]==ColorClass[j]))
-  break;
-  }
-  }
-  }
-  if (k==i) {
-  clique[j] = TRUE;
-  printf("Node %d in clique\n",j);
-  }
-  }
-  max = 0;
-  for (i=0;i<num_node;i++) 
-  if (clique[order[i]]) max++;
-  printf("Lower bound of %d found with Best Coloring %d\n",max,BestColoring);
-  return max;
-  }
-  */
-
-/*int lower_bound(current_color)
-  int current_color;
-  {
-  return 0;
-
-  }
-  */
+/* Lower bound on the colors of any completion of the current coloring.
+   The uncolored vertices of saturation current_color, i.e. the bucket
+   SatSet[current_color], see all the colors used so far: a clique of k of
+   them needs k new colors. The clique is grown greedily in index order
+   (the graph is sorted by degree), and the search stops as soon as the
+   bound reaches BestColoring. */
+int lower_bound(current_color)
+   int current_color;
+{
+   int v,k;
+
+   if (SatSize[current_color] < 2) return current_color+SatSize[current_color];
+   bs_copy(Cand,SatSet[current_color],num_word);
+   k = 0;
+   for (v=bs_next(Cand,num_word,0);v>=0;v=bs_next(Cand,num_word,v+1)) {
+      k++;
+      if (current_color+k >= BestColoring) break;
+      bs_and(Cand,Cand,adj[v],num_word);
+   }
+   return current_color+k;
+}
 
 int color(i,current_color)
    int i;
 {
    int j,new_val;
-   int k,max,count,place;
+   int place;
 
-   if ( prob_count % 10 == 0 ) {
+   /* check the time every 2^16 subproblems: times() is a system call */
+   if ( (prob_count & 0xFFFF) == 0 ) {
       times(&buffer);
       current_time = buffer.tms_utime;
       if (((current_time-start_time)/60.0) > 300.0) { /// TIMEOUT
-         printf("Time out %7.1f - Final Coloring: %d\n",(current_time-start_time)/60.0, BestColoring);
+         printf("Time out %7.1f - Final Coloring: %d",(current_time-start_time)/60.0, BestColoring);
+         print_rate();
          exit(-1);
       }
    }
@@ -404,26 +252,13 @@ int color(i,current_color)
 
    if (i >= num_node) return(current_color);
    /*  printf("Node %d, num_color %d\n",i,current_color);*/
+   if (lower_bound(current_color) >= BestColoring) {
+      prune_count++;
+      return(BestColoring);
+   }
 
    /* Find node with maximum color_adj */
-   max = -1;
-   place = -1;
-   for(k=0;k<num_node;k++) 
-   {
-      /*      count = 0;*/
-      if (Handled[k]) continue;
-      /*      for (j=1;j<=current_color;j++)
-              if (ColorAdj[k][j] > 0) count++;
-              if (count!=ColorCount[k]) printf("Trouble with color count\n");
-              */      
-      /*      printf("ColorCount[%3d] = %d\n",k,ColorCount[k]);*/
-      if ((ColorCount[k] > max) || ((ColorCount[k]==max)&&(ColorAdj[k][0]>ColorAdj[place][0])))
-      {
-         /*	  printf("Best now at %d\n",k);*/
-         max = ColorCount[k];
-         place = k;
-      }
-   }
+   place = bucket_max();
    if (place==-1) 
    {
       printf("Graph is disconnected.  This code needs to be updated for that case.\n");
@@ -432,7 +267,8 @@ int color(i,current_color)
 
 
    Order[i] = place;
-   Handled[place] = TRUE;
+   BS_DEL(Uncolored,place);
+   bucket_remove(place);
    /*  printf("Using node %d at level %d\n",place,i);*/
    for (j=1;j<=current_color;j++) 
    {
@@ -441,13 +277,11 @@ int color(i,current_color)
          ColorClass[place] = j;
          AssignColor(place,j);
          new_val = color(i+1,current_color);
-         if (new_val < BestColoring){
-            BestColoring = new_val;
-            print_colors();
-         }
+         if (update_best(new_val)) print_colors();
          RemoveColor(place,j);
          if (BestColoring<=current_color) {
-            Handled[place] = FALSE;
+            BS_ADD(Uncolored,place);
+            bucket_insert(place);
             return(BestColoring);
          }
       }
@@ -457,21 +291,326 @@ int color(i,current_color)
       ColorClass[place] = current_color+1;
       AssignColor(place,current_color+1);
       new_val = color(i+1,current_color+1);
-      if (new_val < BestColoring) {
-         BestColoring = new_val;
-         print_colors();
-      }
+      if (update_best(new_val)) print_colors();
 
       RemoveColor(place,current_color+1);
    }
-   Handled[place] = FALSE;
+   BS_ADD(Uncolored,place);
+   bucket_insert(place);
    return(BestColoring);
 }
 
+#define ALIGN64(x) (((size_t)(x)+63) & ~(size_t)63)
+
+/* Allocate the adjacency matrix, shared by all the search threads */
+void alloc_arena()
+{
+   char *p;
+   int i;
+
+   num_word = BS_WORDS(num_node);
+   arena = (char *)calloc(ALIGN64((size_t)num_node*sizeof(word_t *))
+                          +ALIGN64((size_t)num_node*num_word*sizeof(word_t))+64,1);
+   if (arena == NULL) {
+      printf("Not enough memory for a graph with %d nodes\n",num_node);
+      exit(1);
+   }
+   p = (char *)ALIGN64(arena);
+   adj = (word_t **)p;             p += ALIGN64((size_t)num_node*sizeof(word_t *));
+   for (i=0;i<num_node;i++)
+      adj[i] = (word_t *)p + (size_t)i*num_word;
+}
+
+/* Allocate the state of the calling thread in one zeroed arena. DSATUR
+   never opens a color above maxdeg+1: a new color is used only when all
+   the smaller ones appear in the neighbourhood, and later on the colors
+   stay below BestColoring. Hence ColorAdj needs maxdeg+2 columns (column 0
+   counts the uncolored neighbours), as set in num_color */
+void alloc_state()
+{
+   size_t sz_cadj,sz_vec,sz_sat,sz_trail;
+   char *p;
+   int i;
+
+   sz_cadj = ALIGN64((size_t)num_node*sizeof(int *)) + ALIGN64((size_t)num_node*num_color*sizeof(int));
+   sz_vec  = ALIGN64((size_t)num_node*sizeof(int));
+   /* a vertex gains at most maxdeg < num_color saturation, plus one
+      counter per AssignColor on the current path */
+   sz_trail = ALIGN64((size_t)num_node*(num_color+1)*sizeof(int));
+   /* one bucket per saturation degree, which is at most maxdeg */
+   sz_sat  = ALIGN64((size_t)num_color*num_word*sizeof(word_t))
+           + ALIGN64((size_t)num_color*sizeof(word_t *)) + ALIGN64((size_t)num_color*sizeof(int));
+   state_arena = (char *)calloc(sz_cadj+3*sz_vec+2*ALIGN64((size_t)num_word*sizeof(word_t))+sz_trail+sz_sat+64,1);
+   if (state_arena == NULL) {
+      printf("Not enough memory for a graph with %d nodes\n",num_node);
+      exit(1);
+   }
+   p = (char *)ALIGN64(state_arena);
+   ColorAdj = (int **)p;           p += ALIGN64((size_t)num_node*sizeof(int *));
+   for (i=0;i<num_node;i++)
+      ColorAdj[i] = (int *)p + (size_t)i*num_color;
+   p += ALIGN64((size_t)num_node*num_color*sizeof(int));
+   ColorClass = (int *)p;          p += sz_vec;
+   Order = (int *)p;               p += sz_vec;
+   ColorCount = (int *)p;          p += sz_vec;
+   Uncolored = (word_t *)p;        p += ALIGN64((size_t)num_word*sizeof(word_t));
+   Cand = (word_t *)p;             p += ALIGN64((size_t)num_word*sizeof(word_t));
+   Trail = (int *)p;               p += sz_trail;
+   SatSet = (word_t **)p;          p += ALIGN64((size_t)num_color*sizeof(word_t *));
+   SatSize = (int *)p;             p += ALIGN64((size_t)num_color*sizeof(int));
+   for (i=0;i<num_color;i++)
+      SatSet[i] = (word_t *)p + (size_t)i*num_word;
+   SatTop = 0;
+}
+
+/* Root of the search: the vertices in RootOrder get colors 1..root_place */
+void init_state()
+{
+   int i;
+
+   prob_count = 0;
+   prune_count = 0;
+   TrailTop = 0;
+   for (i=0;i<num_node;i++)
+      BS_ADD(Uncolored,i);
+   for (i=0;i<num_node;i++)
+      ColorAdj[i][0] = bs_count(adj[i],num_word);
+   for (i=0;i<num_node;i++)
+      bucket_insert(i);
+   for (i=0;i<root_place;i++)
+   {
+      Order[i] = RootOrder[i];
+      BS_DEL(Uncolored,RootOrder[i]);
+      bucket_remove(RootOrder[i]);
+      AssignColor(RootOrder[i],i+1);
+   }
+}
+
+/* Parallel search. The DSATUR tree is cut at split levels below the root:
+   every node at that depth becomes a task, stored as the sequence of its
+   (vertex,color) choices, and the tasks are dealt round robin, in DFS
+   order, to one deque per thread. A thread takes its own tasks from the
+   head, and when it runs out steals from the tail of the others. Each
+   thread replays the choices of a task on its own state and continues
+   with color(); only BestColoring is shared, so the optimal value does
+   not depend on the schedule. */
+int num_thread;
+int split;           /* depth of the tasks below the root */
+int num_task;
+int max_task;
+int *TaskMove;       /* split (vertex,color) pairs per task */
+int *TaskColor;      /* colors used by the task */
+int **DqTask;        /* tasks of each thread... */
+int *DqHead,*DqTail; /* ...in DqTask[t][DqHead[t]..DqTail[t]) */
+pthread_mutex_t *DqLock;
+
+void split_tree(i,current_color,depth)
+   int i,current_color,depth;
+{
+   int j,k,place;
+   int *mv;
+
+   if (current_color >= BestColoring) return;
+   if (i >= num_node) {
+      if (update_best(current_color)) print_colors();
+      return;
+   }
+   if (depth == 0) {
+      if (num_task == max_task) {
+         max_task = 2*max_task+64;
+         TaskMove = (int *)realloc(TaskMove,(size_t)max_task*2*split*sizeof(int));
+         TaskColor = (int *)realloc(TaskColor,(size_t)max_task*sizeof(int));
+      }
+      mv = TaskMove + (size_t)num_task*2*split;
+      for (k=0;k<split;k++) {
+         mv[2*k] = Order[root_place+k];
+         mv[2*k+1] = ColorClass[Order[root_place+k]];
+      }
+      TaskColor[num_task++] = current_color;
+      return;
+   }
+   place = bucket_max();
+   if (place==-1) 
+   {
+      printf("Graph is disconnected.  This code needs to be updated for that case.\n");
+      exit(1);
+   }
+   Order[i] = place;
+   BS_DEL(Uncolored,place);
+   bucket_remove(place);
+   for (j=1;j<=current_color+1;j++)
+   {
+      if (j <= current_color ? !ColorAdj[place][j] : current_color+1 < BestColoring)
+      {
+         ColorClass[place] = j;
+         AssignColor(place,j);
+         split_tree(i+1,(j <= current_color) ? current_color : j,depth-1);
+         RemoveColor(place,j);
+      }
+   }
+   BS_ADD(Uncolored,place);
+   bucket_insert(place);
+}
+
+/* Next task for thread t, stolen from the others if needed; -1 if none */
+int next_task(t)
+   int t;
+{
+   int k,v,task;
+
+   for (k=0;k<num_thread;k++) {
+      v = (t+k) % num_thread;
+      task = -1;
+      pthread_mutex_lock(&DqLock[v]);
+      if (DqHead[v] < DqTail[v])
+         task = (v == t) ? DqTask[v][DqHead[v]++] : DqTask[v][--DqTail[v]];
+      pthread_mutex_unlock(&DqLock[v]);
+      if (task >= 0) return task;
+   }
+   return -1;
+}
+
+void run_task(task)
+   int task;
+{
+   int k,v,c,new_val;
+   int *mv = TaskMove + (size_t)task*2*split;
+
+   if (TaskColor[task] >= BestColoring) return;
+   for (k=0;k<split;k++) {
+      v = mv[2*k];
+      c = mv[2*k+1];
+      Order[root_place+k] = v;
+      BS_DEL(Uncolored,v);
+      bucket_remove(v);
+      ColorClass[v] = c;
+      AssignColor(v,c);
+   }
+   new_val = color(root_place+split,TaskColor[task]);
+   if (update_best(new_val)) print_colors();
+   for (k=split-1;k>=0;k--) {
+      v = mv[2*k];
+      RemoveColor(v,mv[2*k+1]);
+      BS_ADD(Uncolored,v);
+      bucket_insert(v);
+   }
+}
+
+void *worker(arg)
+   void *arg;
+{
+   int task,t = (int)(long)arg;
+
+   alloc_state();
+   init_state();
+   while ((task = next_task(t)) >= 0)
+      run_task(task);
+   __sync_fetch_and_add(&prob_total,prob_count);
+   __sync_fetch_and_add(&prune_total,prune_count);
+   free(state_arena);
+   return NULL;
+}
+
+int color_parallel(threads)
+   int threads;
+{
+   pthread_t *tid;
+   int t,k;
+
+   /* Deepen the cut until there are enough tasks to balance the load */
+   num_thread = threads;
+   num_task = 0;
+   TaskMove = NULL;
+   TaskColor = NULL;
+   for (split=1;root_place+split<=num_node;split++) {
+      num_task = 0;
+      max_task = 0;
+      split_tree(root_place,root_place,split);
+      if (num_task >= 16*num_thread) break;
+   }
+   if (root_place+split > num_node) split = num_node-root_place;
+   printf("Parallel search with %d threads on %d tasks at depth %d\n",num_thread,num_task,split);
+
+   DqTask = (int **)malloc(num_thread*sizeof(int *));
+   DqHead = (int *)calloc(num_thread,sizeof(int));
+   DqTail = (int *)calloc(num_thread,sizeof(int));
+   DqLock = (pthread_mutex_t *)malloc(num_thread*sizeof(pthread_mutex_t));
+   for (t=0;t<num_thread;t++) {
+      DqTask[t] = (int *)malloc((num_task/num_thread+1)*sizeof(int));
+      pthread_mutex_init(&DqLock[t],NULL);
+   }
+   for (k=0;k<num_task;k++) {
+      t = k % num_thread;
+      DqTask[t][DqTail[t]++] = k;
+   }
+
+   tid = (pthread_t *)malloc(num_thread*sizeof(pthread_t));
+   for (t=0;t<num_thread;t++)
+      pthread_create(&tid[t],NULL,worker,(void *)(long)t);
+   for (t=0;t<num_thread;t++)
+      pthread_join(tid[t],NULL);
+
+   for (t=0;t<num_thread;t++) {
+      pthread_mutex_destroy(&DqLock[t]);
+      free(DqTask[t]);
+   }
+   free(tid);
+   free(DqLock);
+   free(DqTail);
+   free(DqHead);
+   free(DqTask);
+   free(TaskColor);
+   free(TaskMove);
+   return BestColoring;
+}
+
+/* Root clique, among the maximal cliques of lb vertices at least streamed
+   by Bron-Kerbosch: a larger clique raises lb (and the minimum size of the
+   enumeration), and among the cliques of the same size the one with the
+   largest degree is colored first, as its vertices constrain the most */
+typedef struct {
+   int *list;        /* best clique */
+   int size;
+   long degree;      /* sum of the degrees of its vertices */
+   bk_stats_t *st;
+} root_clique_t;
+
+int root_clique(clique,size,data)
+   const int *clique;
+   int size;
+   void *data;
+{
+   root_clique_t *R = (root_clique_t *)data;
+   long d = 0;
+   int i;
+
+   for (i=0;i<size;i++) d += bs_count(adj[clique[i]],num_word);
+   if (size > R->size || d > R->degree) {
+      if (size > R->size) R->st->min_size = size;
+      R->size = size;
+      R->degree = d;
+      for (i=0;i<size;i++) R->list[i] = clique[i];
+   }
+   return TRUE;
+}
+
+/* Search nodes per second of CPU time since start_time */
+print_rate()
+{
+   double sec;
+
+   times(&buffer);
+   current_time = buffer.tms_utime;
+   sec = (current_time-start_time)/(double)sysconf(_SC_CLK_TCK);
+   printf(" subproblems: %ld nodes/sec: %.0f pruned by bound: %ld\n",prob_total+prob_count,
+          (sec > 0) ? (prob_total+prob_count)/sec : 0.0,prune_total+prune_count);
+}
+
 print_colors() 
 {
    int i,j;
 
+   pthread_mutex_lock(&print_lock);
    times(&buffer);
    current_time = buffer.tms_utime;
 
@@ -480,12 +619,12 @@ print_colors()
    /*  for (i=0;i<num_node;i++)
        printf("Color[%3d] = %d\n",i,ColorClass[i]);*/
    for (i=0;i<num_node;i++)
-      for (j=0;j<num_node;j++) 
+      for (j=bs_next(adj[i],num_word,0);j>=0;j=bs_next(adj[i],num_word,j+1)) 
       {
-         if (i==j) continue;
-         if (adj[i][j] && (ColorClass[i]==ColorClass[j]))
+         if (ColorClass[i]==ColorClass[j])
             printf("Error with nodes %d and %d and color %d\n",i,j,ColorClass[i]);
       }
+   pthread_mutex_unlock(&print_lock);
 }
 
 main(argc,argv)
@@ -494,8 +633,18 @@ main(argc,argv)
 {
    FILE *fp;
    int m,i,j,k,val;
-   int valid[MAX_NODE],clique[MAX_NODE];
+   int *clique;
+   int maxdeg;
+   int *list;
+   mc_stats_t st;
+   bk_stats_t bk;
+   root_clique_t rc;
+   tc_options_t tc;
+   cg_stats_t cg;
+   int *ls_color;
    int place;
+   int threads;
+   clock_t wall;
 
    clique_options* opts;
    graph_t* g;  
@@ -505,6 +654,9 @@ main(argc,argv)
    int UB;
    int n;
 
+   /// Line buffered output, so that the bounds can be followed from a pipe
+   setvbuf(stdout,NULL,_IOLBF,0);
+
    /// Set the options for using Cliquer
    opts = (clique_options*) malloc (sizeof(clique_options));
    opts->time_function=NULL;
@@ -533,66 +685,120 @@ main(argc,argv)
 
 
    num_node = g->n;
+   maxdeg = 0;
+   for (i = 0; i<num_node; i++)
+      if ( graph_vertex_degree(g, i) > maxdeg )
+         maxdeg = graph_vertex_degree(g, i);
+   num_color = maxdeg+2;
+   alloc_arena();
    for (i = 0; i<num_node; i++)
       for (j = 0; j<num_node; j++) 
-         if ( GRAPH_IS_EDGE(g, i, j) )
-            adj[i][j] = TRUE;
-         else
-            adj[i][j] = FALSE;
+         if ( i != j && GRAPH_IS_EDGE(g, i, j) )
+            BS_ADD(adj[i], j);
    
    /// Free the memory used by Cliquer
    free(table);
    graph_free(g);
    graph_free(g1);
 
-   prob_count = 0;
-   for (i=0;i<num_node;i++)
-      for (j=0;j<=num_node;j++)
-         ColorAdj[i][j] = 0;
-
-   for (i=0;i<num_node;i++)
-      for (j=0;j<num_node;j++)
-         if (adj[i][j]) ColorAdj[i][0]++;
-
-   for (i=0;i<num_node;i++)
-      ColorCount[i]=0;
+   /// Number of search threads (optional second argument)
+   threads = (argc > 2) ? atoi(argv[2]) : 1;
+   if (threads < 1) threads = 1;
 
    times(&buffer);
    start_time=buffer.tms_utime;
    printf("Graph %s read with %d nodes and %d edges\n",argv[1],num_node,m);
-   for (i=0;i<num_node;i++)
-      Handled[i] = FALSE;
    BestColoring = num_node+1;
    /*  ColorClass[0] = 1;
        AssignColor(0,1);
        Handled[0] = TRUE;*/
-   for (i=0;i<num_node;i++) valid[i] = TRUE;
-   best_clique = 0;
-   num_prob = 0;
-   max_prob = 10000;
-
-   lb = max_w_clique(valid,clique,0,num_node);
+   clique = (int *)calloc(num_node,sizeof(int));
+   list = (int *)calloc(num_node,sizeof(int));
+   /// Maximum clique with the bit-parallel solver, within a limit on the nodes,
+   /// starting from a local search clique
+   st.max_nodes = 1000000;
+   st.ls_moves = MC_LS_MOVES;
+   lb = mc_max_clique(num_node,adj,list,&st);
+   /// ... and then the maximal cliques of lb vertices at least, within limits
+   bk.max_cliques = 100000;
+   bk.max_nodes = 1000000;
+   bk.min_size = lb;
+   bk.max_size = 0;
+   rc.list = list;
+   rc.size = lb;
+   rc.degree = 0;
+   rc.st = &bk;
+   for (i=0;i<lb;i++) rc.degree += bs_count(adj[list[i]],num_word);
+   bk_maximal_cliques(num_node,adj,root_clique,&rc,&bk);
+   printf("Clique enumeration: cliques %ld nodes %ld%s\n",bk.cliques,bk.nodes,
+          bk.complete ? " complete" : "");
+   if (rc.size > lb) lb = rc.size;
+   if (bk.complete) st.optimal = TRUE;
+   for (i=0;i<lb;i++) clique[list[i]] = TRUE;
+   RootOrder = (int *)calloc(num_node,sizeof(int));
    place = 0;
    for (i=0;i<num_node;i++) 
    {
       if (clique[i]) 
       {
-         Order[place] = i;
-         Handled[i] = TRUE;
-         place++;
-         AssignColor(i,place);
+         RootOrder[place++] = i;
          for (j=0;j<num_node;j++)
-            if ((i!=j)&&clique[j] && (!adj[i][j])) printf("Result is not a clique!\n");
+            if ((i!=j)&&clique[j] && (!BS_CONTAINS(adj[i],j))) printf("Result is not a clique!\n");
 
       }
    }
+   root_place = place;
+   alloc_state();
+   init_state();
 
    printf("Lower bound is %d",lb);
-   if (num_prob >=max_prob) printf(" (not confirmed)\n");
+   if (!st.optimal) printf(" (not confirmed)\n");
    else printf("\n");
-   val = color(place,place);
+
+   /// Upper bound by DSATUR and TabuCol (optional third argument: TabuCol
+   /// iterations for each number of colors), so that the exact search only
+   /// looks for colorings better than the local search one
+   tc.max_iter = (argc > 3) ? atol(argv[3]) : 100000;
+   tc.threads = threads;
+   tc.lb = lb;
+   tc.seed = 13;
+   ls_color = (int *)calloc(num_node,sizeof(int));
+   BestColoring = tc_color(num_node,adj,ls_color,&tc);
    times(&buffer);
    current_time=buffer.tms_utime;
+   printf("Upper bound is %d (DSATUR %d, TabuCol iterations %ld), time:%7.1f\n",
+          BestColoring,tc.greedy,tc.iter,(current_time-start_time)/60.0);
+
+   /// Lower bound by column generation, starting from the local search
+   /// coloring (optional fourth argument: time limit in seconds)
+   if (lb < BestColoring) {
+      cg.time_limit = (argc > 4) ? atof(argv[4]) : 60;
+      cg.max_nodes = 100000;
+      val = cg_lower_bound(num_node,adj,ls_color,&cg);
+      if (val > lb) lb = val;
+      times(&buffer);
+      current_time=buffer.tms_utime;
+      printf("LP bound is %d (LP %.3f%s, columns %d, pivots %ld), time:%7.1f\n",
+             val,cg.lp,cg.optimal ? " optimal" : "",cg.columns,cg.pivots,
+             (current_time-start_time)/60.0);
+   }
+   free(ls_color);
+   if (threads > 1) {
+      wall = times(&buffer);
+      val = color_parallel(threads);
+      printf("Parallel search wall time: %.2f sec\n",(times(&buffer)-wall)/(double)sysconf(_SC_CLK_TCK));
+   }
+   else
+      val = color(place,place);
+   times(&buffer);
+   current_time=buffer.tms_utime;
+
+   printf("Best coloring has value %d, time:%7.1f",val,(current_time-start_time)/60.0);
+   print_rate();
 
-   printf("Best coloring has value %d, subproblems: %d time:%7.1f\n",val,prob_count,(current_time-start_time)/60.0);
+   free(RootOrder);
+   free(list);
+   free(clique);
+   free(state_arena);
+   free(arena);
 }
@@ -0,0 +1,620 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Bit-parallel maximum clique solver (see maxclique.h)
+ */
+
+#include <stdlib.h>
+
+#include "maxclique.h"
+
+/// Smallest density of a graph for the local search of the initial clique
+#define MC_LS_DENSITY  0.5
+
+/// Buffers of a search level, allocated the first time the level is reached
+typedef struct {
+   word_t  *P;        /* candidate set */
+   word_t  *U;        /* uncolored candidates */
+   word_t  *Q;        /* candidates for the current color class */
+   word_t  *cand;     /* candidates during unit propagation */
+   int     *list;     /* candidates grouped by color class */
+   int     *color;    /* color of list[i] */
+   int     *cstart;   /* class k is list[cstart[k-1]..cstart[k]) */
+   char    *used;     /* class already used by a failed literal */
+   char    *skip;     /* list[i] pruned by a failed literal */
+   int     *inv;      /* classes involved in the current propagation */
+} mc_level_t;
+
+typedef struct {
+   int          n, w;
+   word_t     **adj;       /* renumbered adjacency rows */
+   int         *perm;      /* new index -> original vertex */
+   int         *C;         /* current clique */
+   int         *best;      /* best clique */
+   int          nbest;
+   int          stop;
+   int          num_level;
+   mc_level_t  *level;
+   mc_stats_t  *st;
+} mc_t;
+
+static mc_level_t* mc_level(mc_t* M, int l) {
+   mc_level_t* L = &M->level[l];
+   if ( l == M->num_level ) {
+      L->P      = (word_t*) malloc(4*M->w*sizeof(word_t));
+      L->U      = L->P + M->w;
+      L->Q      = L->U + M->w;
+      L->cand   = L->Q + M->w;
+      L->list   = (int*) malloc(M->n*sizeof(int));
+      L->color  = (int*) malloc(M->n*sizeof(int));
+      L->cstart = (int*) malloc((M->n+2)*sizeof(int));
+      L->inv    = (int*) malloc((M->n+2)*sizeof(int));
+      L->used   = (char*) malloc((M->n+2)*sizeof(char));
+      L->skip   = (char*) malloc(M->n*sizeof(char));
+      M->num_level++;
+   }
+   return L;
+}
+
+/// Degeneracy ordering (Batagelj-Zaversnik bucket peeling): on return
+/// perm[0] is the vertex removed last, i.e. the vertices of the densest
+/// core come first. Returns the degeneracy, so a clique has at most one
+/// vertex more
+static int mc_degeneracy(int n, int w, word_t* const* adj, int* perm) {
+   int  i, v, u, d, md = 0, core = 0;
+   int* deg  = (int*) malloc(n*sizeof(int));
+   int* pos  = (int*) malloc(n*sizeof(int));
+   int* vert = (int*) malloc(n*sizeof(int));
+   int* bin;
+   for ( v = 0; v < n; ++v ) {
+      deg[v] = bs_count(adj[v], w);
+      if ( deg[v] > md )
+         md = deg[v];
+   }
+   bin = (int*) calloc(md+1, sizeof(int));
+   for ( v = 0; v < n; ++v )
+      bin[deg[v]]++;
+   for ( d = 0, i = 0; d <= md; ++d ) {
+      int c = bin[d];
+      bin[d] = i;
+      i += c;
+   }
+   for ( v = 0; v < n; ++v ) {
+      pos[v] = bin[deg[v]];
+      vert[pos[v]] = v;
+      bin[deg[v]]++;
+   }
+   for ( d = md; d > 0; --d )
+      bin[d] = bin[d-1];
+   bin[0] = 0;
+   for ( i = 0; i < n; ++i ) {
+      v = vert[i];
+      perm[n-1-i] = v;
+      if ( deg[v] > core )
+         core = deg[v];
+      for ( u = bs_next(adj[v], w, 0); u >= 0; u = bs_next(adj[v], w, u+1) )
+         if ( deg[u] > deg[v] ) {
+            /// Move u to the front of its bin, then decrease its degree
+            int du = deg[u], pu = pos[u], pw = bin[du], x = vert[pw];
+            if ( u != x ) {
+               pos[u] = pw; vert[pw] = u;
+               pos[x] = pu; vert[pu] = x;
+            }
+            bin[du]++;
+            deg[u]--;
+         }
+   }
+   free(bin);
+   free(vert);
+   free(pos);
+   free(deg);
+   return core;
+}
+
+/// Unit propagation of candidate v over the classes 1..m not used yet:
+/// if some class is left without candidates, the involved classes are
+/// marked as used and 1 is returned
+static int mc_failed_literal(mc_t* M, mc_level_t* L, int v, int m) {
+   int c, i, u, x = 0, cnt, ninv = 0, progress = 1;
+   bs_copy(L->cand, M->adj[v], M->w);
+   while ( progress ) {
+      progress = 0;
+      for ( c = 1; c <= m; ++c ) {
+         if ( L->used[c] )
+            continue;
+         cnt = 0;
+         for ( i = L->cstart[c-1]; i < L->cstart[c] && cnt < 2; ++i ) {
+            u = L->list[i];
+            if ( BS_CONTAINS(L->cand, u) ) {
+               cnt++;
+               x = u;
+            }
+         }
+         if ( cnt == 0 ) {   /// Conflict: v cannot extend the bound of these classes
+            L->used[c] = 1;
+            return 1;
+         }
+         if ( cnt == 1 ) {   /// Unit class: x is forced
+            L->used[c] = 2;
+            L->inv[ninv++] = c;
+            bs_and(L->cand, L->cand, M->adj[x], M->w);
+            progress = 1;
+         }
+      }
+   }
+   /// No conflict: release the classes involved
+   for ( i = 0; i < ninv; ++i )
+      L->used[L->inv[i]] = 0;
+   return 0;
+}
+
+/// Pseudo-random numbers (xorshift64)
+static inline uint64_t mc_rand(uint64_t* s) {
+   uint64_t x = *s;
+   x ^= x << 13;
+   x ^= x >> 7;
+   x ^= x << 17;
+   return *s = x;
+}
+
+/// Uniform in [0, n): the draws in the last incomplete block of n are
+/// rejected, so that the modulo has no bias
+static inline int mc_rand_below(uint64_t* s, int n) {
+   uint64_t r, lim = UINT64_MAX - UINT64_MAX % (uint64_t)n;
+   do r = mc_rand(s); while ( r >= lim );
+   return (int)(r % (uint64_t)n);
+}
+
+/// State of the local search: hit[u] counts the clique vertices adjacent to
+/// u, and vert[] has the vertices sorted by hit, the bucket h being
+/// vert[bin[h]..bin[h+1])
+typedef struct {
+   int  *hit, *vert, *vpos, *bin;
+} mc_ls_t;
+
+/// Add d (+1 or -1) to hit[u] for the neighbours u of v, moving each u to
+/// the next bucket: O(n/64 + degree of v)
+static void mc_ls_hit(mc_ls_t* S, word_t* const* adj, int w, int v, int d) {
+   int u, h, p, x;
+   for ( u = bs_next(adj[v], w, 0); u >= 0; u = bs_next(adj[v], w, u+1) ) {
+      h = S->hit[u];
+      /// Swap u with the last vertex of its bucket (the first one, if d < 0)
+      p = (d > 0) ? --S->bin[h+1] : S->bin[h]++;
+      x = S->vert[p];
+      S->vert[S->vpos[u]] = x;
+      S->vpos[x] = S->vpos[u];
+      S->vert[p] = u;
+      S->vpos[u] = p;
+      S->hit[u] += d;
+   }
+}
+
+/// Tabu local search for the initial clique, with add and swap moves: the
+/// vertices out of the clique C in the bucket |C| can be added, those in
+/// the bucket |C|-1 can replace their only non-neighbour in C, so a move
+/// scans only its candidates. A removed vertex is tabu for a few moves;
+/// when no move is left, or after n moves without an improvement, a random
+/// vertex is forced in and its non-neighbours are dropped. Starts from
+/// M->best and updates it in place, within 'max_iter' moves.
+static void mc_local_search(mc_t* M, long max_iter) {
+   int            n = M->n, w = M->w;
+   int            i, h, v, x, nc = 0, cnt, last;
+   int           *C    = (int*) malloc(n*sizeof(int));
+   int           *pos  = (int*) malloc(n*sizeof(int));
+   long          *tabu = (long*) calloc(n, sizeof(long));
+   long           it;
+   uint64_t       seed = 88172645463325252ULL;
+   mc_ls_t        S;
+
+   S.hit  = (int*) calloc(n, sizeof(int));
+   S.vert = (int*) malloc(n*sizeof(int));
+   S.vpos = (int*) malloc(n*sizeof(int));
+   S.bin  = (int*) malloc((n+2)*sizeof(int));
+   for ( v = 0; v < n; ++v ) {
+      pos[v] = -1;
+      S.vert[v] = v;
+      S.vpos[v] = v;
+   }
+   S.bin[0] = 0;
+   for ( h = 1; h <= n+1; ++h )
+      S.bin[h] = n;
+   for ( i = 0; i < M->nbest; ++i ) {
+      v = M->best[i];
+      C[nc] = v;
+      pos[v] = nc++;
+      mc_ls_hit(&S, M->adj, w, v, 1);
+   }
+   last = 0;
+   for ( it = 1; it <= max_iter && nc < n; ++it ) {
+      /// Add move, else swap move, picked at random among the non-tabu ones
+      x = -1;
+      cnt = 0;
+      for ( i = S.bin[nc]; i < S.bin[nc+1]; ++i ) {
+         v = S.vert[i];
+         if ( tabu[v] < it && mc_rand_below(&seed, ++cnt) == 0 )
+            x = v;
+      }
+      if ( x < 0 && nc > 0 ) {
+         for ( i = S.bin[nc-1]; i < S.bin[nc]; ++i ) {
+            v = S.vert[i];
+            if ( pos[v] < 0 && tabu[v] < it && mc_rand_below(&seed, ++cnt) == 0 )
+               x = v;
+         }
+      }
+      if ( x < 0 || it - last > n ) {
+         /// Perturbation: force a random vertex in
+         do x = mc_rand_below(&seed, n); while ( pos[x] >= 0 );
+         last = it;
+      }
+      /// Drop the non-neighbours of x, then add x
+      for ( i = 0; i < nc; ) {
+         v = C[i];
+         if ( BS_CONTAINS(M->adj[x], v) ) {
+            ++i;
+            continue;
+         }
+         C[i] = C[--nc];
+         pos[C[i]] = i;
+         pos[v] = -1;
+         mc_ls_hit(&S, M->adj, w, v, -1);
+         tabu[v] = it + 7 + mc_rand_below(&seed, 10);
+      }
+      C[nc] = x;
+      pos[x] = nc++;
+      mc_ls_hit(&S, M->adj, w, x, 1);
+      if ( nc > M->nbest ) {
+         M->nbest = nc;
+         for ( i = 0; i < nc; ++i )
+            M->best[i] = C[i];
+         last = it;
+      }
+   }
+   free(S.bin);
+   free(S.vpos);
+   free(S.vert);
+   free(S.hit);
+   free(tabu);
+   free(pos);
+   free(C);
+}
+
+static void mc_expand(mc_t* M, int l, int csize) {
+   mc_level_t* L = &M->level[l];
+   mc_level_t* L1;
+   int w = M->w;
+   int k, v, i, nlist, kmin, first;
+
+   M->st->nodes++;
+   if ( M->st->max_nodes > 0 && M->st->nodes > M->st->max_nodes ) {
+      M->stop = 1;
+      return;
+   }
+
+   /// Greedy coloring of P by color classes (vertices are in degeneracy order)
+   bs_copy(L->U, L->P, w);
+   nlist = 0;
+   k = 0;
+   while ( !bs_empty(L->U, w) ) {
+      L->cstart[k++] = nlist;
+      bs_copy(L->Q, L->U, w);
+      for ( v = bs_next(L->Q, w, 0); v >= 0; v = bs_next(L->Q, w, v+1) ) {
+         BS_DEL(L->U, v);
+         /// Only the words from v on are still to be scanned
+         bs_andnot(L->Q + (v >> 6), L->Q + (v >> 6), M->adj[v] + (v >> 6), w - (v >> 6));
+         L->list[nlist] = v;
+         L->color[nlist] = k;
+         L->skip[nlist] = 0;
+         nlist++;
+      }
+   }
+   L->cstart[k] = nlist;
+
+   /// Only the vertices of color >= kmin can give a clique better than the best
+   kmin = M->nbest - csize + 1;
+   if ( kmin < 1 )
+      kmin = 1;
+   if ( kmin > k )
+      return;
+   first = L->cstart[kmin-1];
+
+   /// Failed literals over the first kmin-1 classes, by increasing color
+   if ( kmin > 1 ) {
+      for ( i = 1; i < kmin; ++i )
+         L->used[i] = 0;
+      for ( i = first; i < nlist; ++i ) {
+         if ( !mc_failed_literal(M, L, L->list[i], kmin-1) )
+            break;
+         L->skip[i] = 1;
+         M->st->pruned++;
+      }
+   }
+
+   /// Branch by decreasing color
+   L1 = mc_level(M, l+1);
+   L = &M->level[l];
+   for ( i = nlist-1; i >= first; --i ) {
+      if ( csize + L->color[i] <= M->nbest )
+         return;
+      if ( L->skip[i] )
+         continue;
+      v = L->list[i];
+      M->C[csize] = v;
+      bs_and(L1->P, L->P, M->adj[v], w);
+      if ( bs_empty(L1->P, w) ) {
+         if ( csize+1 > M->nbest ) {
+            M->nbest = csize+1;
+            for ( k = 0; k <= csize; ++k )
+               M->best[k] = M->C[k];
+         }
+      } else {
+         mc_expand(M, l+1, csize+1);
+         if ( M->stop )
+            return;
+      }
+      BS_DEL(L->P, v);
+   }
+}
+
+int mc_max_clique(int n, word_t* const* adj, int* clique, mc_stats_t* st) {
+   mc_t        M;
+   mc_stats_t  tmp;
+   int         i, j, u, core, *inv;
+   long        deg = 0;
+   word_t     *rows;
+
+   if ( st == NULL ) {
+      tmp.max_nodes = 0;
+      tmp.ls_moves = 0;
+      st = &tmp;
+   }
+   st->nodes = 0;
+   st->pruned = 0;
+   st->optimal = 1;
+   if ( n == 0 )
+      return 0;
+
+   M.n = n;
+   M.w = BS_WORDS(n);
+   M.st = st;
+   M.stop = 0;
+   M.perm  = (int*) malloc(n*sizeof(int));
+   M.C     = (int*) malloc(n*sizeof(int));
+   M.best  = (int*) malloc(n*sizeof(int));
+   M.adj   = (word_t**) malloc(n*sizeof(word_t*));
+   M.level = (mc_level_t*) calloc(n+2, sizeof(mc_level_t));
+   M.num_level = 0;
+
+   /// Renumber the graph along the degeneracy ordering
+   core = mc_degeneracy(n, M.w, adj, M.perm);
+   inv  = (int*) malloc(n*sizeof(int));
+   rows = (word_t*) calloc((size_t)n*M.w, sizeof(word_t));
+   for ( i = 0; i < n; ++i )
+      inv[M.perm[i]] = i;
+   for ( i = 0; i < n; ++i ) {
+      M.adj[i] = rows + (size_t)i*M.w;
+      for ( u = bs_next(adj[M.perm[i]], M.w, 0); u >= 0; u = bs_next(adj[M.perm[i]], M.w, u+1) ) {
+         BS_ADD(M.adj[i], inv[u]);
+         deg++;
+      }
+   }
+
+   /// Initial clique: greedy along the ordering
+   M.nbest = 0;
+   for ( i = 0; i < n; ++i ) {
+      for ( j = 0; j < M.nbest; ++j )
+         if ( !BS_CONTAINS(M.adj[i], M.best[j]) )
+            break;
+      if ( j == M.nbest )
+         M.best[M.nbest++] = i;
+   }
+   /// The local search pays off on dense graphs: on sparse ones the greedy
+   /// clique is close to the maximum, and the search below is fast
+   if ( st->ls_moves > 0 && M.nbest <= core && deg >= MC_LS_DENSITY*n*(n-1.0) )
+      mc_local_search(&M, st->ls_moves);
+
+   /// Search from the root
+   mc_level(&M, 0);
+   bs_clear(M.level[0].P, M.w);
+   for ( i = 0; i < n; ++i )
+      BS_ADD(M.level[0].P, i);
+   mc_expand(&M, 0, 0);
+   st->optimal = !M.stop;
+
+   for ( i = 0; i < M.nbest; ++i )
+      clique[i] = M.perm[M.best[i]];
+
+   for ( i = 0; i < M.num_level; ++i ) {
+      free(M.level[i].P);
+      free(M.level[i].list);
+      free(M.level[i].color);
+      free(M.level[i].cstart);
+      free(M.level[i].inv);
+      free(M.level[i].used);
+      free(M.level[i].skip);
+   }
+   free(M.level);
+   free(rows);
+   free(inv);
+   free(M.adj);
+   free(M.best);
+   free(M.C);
+   free(M.perm);
+
+   return M.nbest;
+}
+
+/// Buffers of a level of the maximum weight clique search
+typedef struct {
+   word_t  *P;        /* candidate set */
+   int     *list;     /* candidates grouped by color class */
+   double  *bound;    /* bound[i]: weight of the classes up to list[i] */
+} mwc_level_t;
+
+typedef struct {
+   int           n, w;
+   word_t      **adj;
+   double       *wt;
+   word_t       *U, *Q;
+   int          *C;
+   int          *best;
+   int           nbest;
+   double        bestw;
+   int           stop;
+   int           num_level;
+   mwc_level_t  *level;
+   mc_stats_t   *st;
+} mwc_t;
+
+static mwc_level_t* mwc_level(mwc_t* M, int l) {
+   mwc_level_t* L = &M->level[l];
+   if ( l == M->num_level ) {
+      L->P     = (word_t*) malloc(M->w*sizeof(word_t));
+      L->list  = (int*) malloc(M->n*sizeof(int));
+      L->bound = (double*) malloc(M->n*sizeof(double));
+      M->num_level++;
+   }
+   return L;
+}
+
+static void mwc_expand(mwc_t* M, int l, int csize, double cw) {
+   mwc_level_t* L = &M->level[l];
+   mwc_level_t* L1;
+   int      w = M->w;
+   int      i, j, v, nlist = 0, first;
+   double   acc = 0, maxw;
+
+   M->st->nodes++;
+   if ( M->st->max_nodes > 0 && M->st->nodes > M->st->max_nodes ) {
+      M->stop = 1;
+      return;
+   }
+
+   /// Greedy coloring of P: a clique has at most one vertex of each class
+   bs_copy(M->U, L->P, w);
+   while ( !bs_empty(M->U, w) ) {
+      bs_copy(M->Q, M->U, w);
+      first = nlist;
+      maxw = 0;
+      for ( v = bs_next(M->Q, w, 0); v >= 0; v = bs_next(M->Q, w, v+1) ) {
+         BS_DEL(M->U, v);
+         bs_andnot(M->Q + (v >> 6), M->Q + (v >> 6), M->adj[v] + (v >> 6), w - (v >> 6));
+         L->list[nlist++] = v;
+         if ( M->wt[v] > maxw )
+            maxw = M->wt[v];
+      }
+      acc += maxw;
+      for ( i = first; i < nlist; ++i )
+         L->bound[i] = acc;
+   }
+
+   /// Branch by decreasing bound
+   L1 = mwc_level(M, l+1);
+   L = &M->level[l];
+   for ( i = nlist-1; i >= 0; --i ) {
+      if ( cw + L->bound[i] <= M->bestw )
+         return;
+      v = L->list[i];
+      M->C[csize] = v;
+      bs_and(L1->P, L->P, M->adj[v], w);
+      if ( bs_empty(L1->P, w) ) {
+         if ( cw + M->wt[v] > M->bestw ) {
+            M->bestw = cw + M->wt[v];
+            M->nbest = csize+1;
+            for ( j = 0; j <= csize; ++j )
+               M->best[j] = M->C[j];
+         }
+      } else {
+         mwc_expand(M, l+1, csize+1, cw + M->wt[v]);
+         if ( M->stop )
+            return;
+      }
+      BS_DEL(L->P, v);
+   }
+}
+
+double mc_max_weight_clique(int n, word_t* const* adj, const double* w, int* clique,
+                            int* size, mc_stats_t* st) {
+   mwc_t        M;
+   mc_stats_t   tmp;
+   int          i, j, u, *perm, *inv;
+   word_t      *rows;
+
+   if ( st == NULL ) {
+      tmp.max_nodes = 0;
+      st = &tmp;
+   }
+   st->nodes = 0;
+   st->pruned = 0;
+   st->optimal = 1;
+   *size = 0;
+   if ( n <= 0 )
+      return 0;
+
+   /// Renumber the vertices by decreasing weight, so that the heavy vertices
+   /// lead the color classes
+   perm = (int*) malloc(n*sizeof(int));
+   inv  = (int*) malloc(n*sizeof(int));
+   for ( i = 0; i < n; ++i )
+      perm[i] = i;
+   for ( i = 1; i < n; ++i )
+      for ( j = i; j > 0 && w[perm[j]] > w[perm[j-1]]; --j ) {
+         u = perm[j];
+         perm[j] = perm[j-1];
+         perm[j-1] = u;
+      }
+   for ( i = 0; i < n; ++i )
+      inv[perm[i]] = i;
+
+   M.n = n;
+   M.w = BS_WORDS(n);
+   M.st = st;
+   M.stop = 0;
+   M.adj   = (word_t**) malloc(n*sizeof(word_t*));
+   M.wt    = (double*) malloc(n*sizeof(double));
+   rows    = (word_t*) calloc((size_t)n*M.w, sizeof(word_t));
+   for ( i = 0; i < n; ++i ) {
+      M.adj[i] = rows + (size_t)i*M.w;
+      M.wt[i] = w[perm[i]];
+      for ( u = bs_next(adj[perm[i]], M.w, 0); u >= 0; u = bs_next(adj[perm[i]], M.w, u+1) )
+         BS_ADD(M.adj[i], inv[u]);
+   }
+   M.U     = (word_t*) malloc(2*M.w*sizeof(word_t));
+   M.Q     = M.U + M.w;
+   M.C     = (int*) malloc(n*sizeof(int));
+   M.best  = (int*) malloc(n*sizeof(int));
+   M.level = (mwc_level_t*) calloc(n+2, sizeof(mwc_level_t));
+   M.num_level = 0;
+
+   /// Initial clique: the heaviest vertex
+   M.best[0] = 0;
+   M.nbest = 1;
+   M.bestw = M.wt[0];
+
+   mwc_level(&M, 0);
+   bs_clear(M.level[0].P, M.w);
+   for ( i = 0; i < n; ++i )
+      BS_ADD(M.level[0].P, i);
+   mwc_expand(&M, 0, 0, 0.0);
+   st->optimal = !M.stop;
+
+   for ( i = 0; i < M.nbest; ++i )
+      clique[i] = perm[M.best[i]];
+   *size = M.nbest;
+
+   for ( i = 0; i < M.num_level; ++i ) {
+      free(M.level[i].P);
+      free(M.level[i].list);
+      free(M.level[i].bound);
+   }
+   free(M.level);
+   free(M.best);
+   free(M.C);
+   free(M.U);
+   free(rows);
+   free(M.wt);
+   free(M.adj);
+   free(inv);
+   free(perm);
+   return M.bestw;
+}
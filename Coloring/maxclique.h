@@ -0,0 +1,60 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Exact maximum clique solver in the style of BBMC (San Segundo et al.):
+ *  the candidate sets are bitsets, the upper bounds come from a greedy
+ *  coloring of the candidates (Tomita's MCS), and the vertices are first
+ *  renumbered by a degeneracy ordering. Before branching, the candidates
+ *  whose color exceeds the bound are tested with unit propagation over the
+ *  color classes (MaxSAT-style failed literals, as in IncMaxCLQ): every
+ *  vertex that fails over a set of classes disjoint from those used so far
+ *  can be pruned. The initial clique comes from a tabu local search with
+ *  add and swap moves, which on dense graphs is far better than the greedy
+ *  one and lets the bound prune from the first nodes. The search keeps the
+ *  add and swap candidates in buckets of missed neighbours, runs for a fixed
+ *  number of moves, and is skipped when the greedy clique meets the
+ *  degeneracy bound or the graph is sparse, where the greedy one is tight.
+ *  The solver is written in C and can be used from C++.
+ *
+ *  The maximum weight clique uses the same bitsets, with the weighted
+ *  coloring bound: the sum over the color classes of their largest weight.
+ */
+
+#ifndef _MAXCLIQUE_H_
+#define _MAXCLIQUE_H_
+
+#include "bitset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+   long   max_nodes;   /* limit on the search nodes (0 for no limit) */
+   long   ls_moves;    /* local search moves for the initial clique (0 for none) */
+   long   nodes;       /* search nodes visited */
+   long   pruned;      /* candidates pruned by the failed literal test */
+   int    optimal;     /* 1 if the clique is proved to be maximum */
+} mc_stats_t;
+
+/// Local search moves of the callers: about a second on 1000 vertices
+#define MC_LS_MOVES  100000L
+
+/// Maximum clique of the graph with 'n' vertices and adjacency rows 'adj'
+/// (bitsets of BS_WORDS(n) words, no loops). On return clique[0..size)
+/// lists the vertices of the best clique found, and its size is returned.
+/// 'st' may be NULL; otherwise st->max_nodes and st->ls_moves are read, the
+/// rest is written.
+int mc_max_clique(int n, word_t* const* adj, int* clique, mc_stats_t* st);
+
+/// Maximum weight clique, with weights w[0..n) >= 0: as mc_max_clique, and
+/// the weight of the clique is returned. st->pruned and st->ls_moves are not used
+double mc_max_weight_clique(int n, word_t* const* adj, const double* w, int* clique,
+                            int* size, mc_stats_t* st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MAXCLIQUE_H_ */
@@ -1,30 +1,35 @@
 import sys
+import json
 from path import path
 
 d = path(sys.argv[1])
 
 tim = {}
 sol = {}
+branches = []
 
-for i in [0, 1]:
-    for f in d.files("*.dom.log"+str(i)+"-14"):
-        log = open(f,'r')
-        ist = f.split('/')[5].split(".col")[0]
-        if ist not in tim:
-            tim[ist] = []
-            sol[ist] = []
-        for line in log:
-            l = line.strip().split(' ')
-            if l[0] == "Nodes":
-                if float(l[3]) > 300.0:
-                    tim[ist].append( 300 )
-                else:
-                    tim[ist].append( l[3] )
-            if l[0] == "X(G)":
-                sol[ist].append( l[2] )
+# One log per instance, written by GeCol: besides the text output, every
+# search writes its statistics as JSON lines, with an "event" field. A
+# portfolio run writes a "strategy" line for each branching, a single run
+# an "end" line with its own branching (the "end" line of a portfolio has
+# branch -1, and it is skipped)
+for f in d.files("*.dom.log"):
+    log = open(f,'r')
+    ist = f.name.split(".col")[0]
+    tim[ist] = {}
+    for line in log:
+        if not line.startswith('{'):
+            continue
+        s = json.loads(line)
+        if s["event"] in ("strategy", "end") and s["branch"] >= 0:
+            b = s["branch"]
+            if b not in branches:
+                branches.append( b )
+            tim[ist][b] = min(s["time"], 300.0)
+            sol[ist] = s["ub"]
 
-print "Istance NoSym LDBS"
+branches.sort()
+print "Istance X(G)", ' '.join(["B"+str(b) for b in branches])
 for d,t in sorted(tim.iteritems()):
     if t:
-        if len(t) == 2:
-            print d, t[0], t[1]
+        print d, sol[d], ' '.join([str(t.get(b,'-')) for b in branches])
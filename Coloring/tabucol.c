@@ -0,0 +1,295 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  DSATUR and TabuCol upper bounds for graph coloring (see tabucol.h)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "tabucol.h"
+
+/// Graph in CSR form: the neighbours of v are nbr[start[v]..start[v+1])
+typedef struct {
+   int             n;
+   int            *start;
+   int            *nbr;
+   tc_options_t   *opt;
+   pthread_mutex_t lock;
+   volatile int    best;      /* colors of the best coloring */
+   int            *color;     /* best coloring */
+} tc_shared_t;
+
+/// A run of TabuCol, with its own seed
+typedef struct {
+   tc_shared_t    *S;
+   unsigned int    seed;
+} tc_run_t;
+
+/// Pseudo-random numbers (xorshift), one state for each run
+static inline unsigned int tc_rand(unsigned int* s) {
+   unsigned int x = *s;
+   x ^= x << 13;
+   x ^= x >> 17;
+   x ^= x << 5;
+   return *s = x;
+}
+
+int tc_dsatur(int n, word_t* const* adj, int* color) {
+   int      w = BS_WORDS(n);
+   int      i, b, v, u, c, k = 0, nleft;
+   int     *sat  = (int*) malloc(n*sizeof(int));
+   int     *deg  = (int*) malloc(n*sizeof(int));
+   int     *left = (int*) malloc(n*sizeof(int));
+   /// seen[v] is the set of the colors of the neighbours of v
+   word_t  *seen = (word_t*) calloc((size_t)n*w, sizeof(word_t));
+   word_t  *row;
+
+   for ( v = 0; v < n; ++v ) {
+      color[v] = -1;
+      sat[v]   = 0;
+      deg[v]   = bs_count(adj[v], w);
+      left[v]  = v;
+   }
+   for ( nleft = n; nleft > 0; ) {
+      /// Max saturation, ties broken by the degree in the uncolored graph
+      b = 0;
+      for ( i = 1; i < nleft; ++i ) {
+         v = left[i];
+         u = left[b];
+         if ( sat[v] > sat[u] || (sat[v] == sat[u] && deg[v] > deg[u]) )
+            b = i;
+      }
+      v = left[b];
+      left[b] = left[--nleft];
+      row = seen + (size_t)v*w;
+      for ( c = 0; BS_CONTAINS(row, c); ++c )
+         ;
+      color[v] = c;
+      if ( c+1 > k )
+         k = c+1;
+      for ( u = bs_next(adj[v], w, 0); u >= 0; u = bs_next(adj[v], w, u+1) )
+         if ( color[u] < 0 ) {
+            deg[u]--;
+            row = seen + (size_t)u*w;
+            if ( !BS_CONTAINS(row, c) ) {
+               BS_ADD(row, c);
+               sat[u]++;
+            }
+         }
+   }
+   free(seen);
+   free(left);
+   free(deg);
+   free(sat);
+   return k;
+}
+
+/// TabuCol for a coloring with k colors, starting from color[] (in 0..k-1).
+/// Returns 1 if color[] is a proper coloring on return, 0 if the run ends
+/// after max_iter iterations or because another run already found a
+/// coloring with k colors. '*iter' counts the iterations done
+static int tc_tabucol(tc_shared_t* S, int k, int* color, unsigned int* seed, long* iter) {
+   int      n = S->n;
+   int     *start = S->start, *nbr = S->nbr;
+   long     max_iter = S->opt->max_iter;
+   int     *gamma = (int*) calloc((size_t)n*k, sizeof(int));
+   long    *tabu  = (long*) calloc((size_t)n*k, sizeof(long));
+   int     *cv    = (int*) malloc(n*sizeof(int));   /* conflicting vertices */
+   int     *pos   = (int*) malloc(n*sizeof(int));   /* position in cv, or -1 */
+   int      ncv = 0, f = 0, best_f, found;
+   int      i, j, v, u, c, old, d, bd, bv, bc, ties;
+   long     it;
+
+   for ( v = 0; v < n; ++v )
+      for ( j = start[v]; j < start[v+1]; ++j )
+         gamma[(size_t)v*k + color[nbr[j]]]++;
+   for ( v = 0; v < n; ++v ) {
+      pos[v] = -1;
+      if ( gamma[(size_t)v*k + color[v]] > 0 ) {
+         pos[v] = ncv;
+         cv[ncv++] = v;
+         f += gamma[(size_t)v*k + color[v]];
+      }
+   }
+   f /= 2;
+   best_f = f;
+
+   for ( it = 0; f > 0 && it < max_iter; ++it ) {
+      /// Another run found a coloring with k colors
+      if ( (it & 1023) == 0 && S->best <= k )
+         break;
+      /// Best non tabu move, or tabu move that improves on the best conflicts
+      bd = n;
+      bv = bc = -1;
+      ties = 0;
+      for ( i = 0; i < ncv; ++i ) {
+         int* gv;
+         v  = cv[i];
+         gv = gamma + (size_t)v*k;
+         old = color[v];
+         for ( c = 0; c < k; ++c ) {
+            if ( c == old )
+               continue;
+            d = gv[c] - gv[old];
+            if ( d > bd )
+               continue;
+            if ( tabu[(size_t)v*k + c] > it && f+d >= best_f )
+               continue;
+            if ( d < bd ) {
+               bd = d;
+               ties = 0;
+            }
+            if ( tc_rand(seed) % ++ties == 0 ) {
+               bv = v;
+               bc = c;
+            }
+         }
+      }
+      if ( bv < 0 )
+         continue;
+
+      /// Move bv to color bc and update gamma and the conflicting vertices
+      old = color[bv];
+      color[bv] = bc;
+      for ( j = start[bv]; j < start[bv+1]; ++j ) {
+         int* gu;
+         u  = nbr[j];
+         gu = gamma + (size_t)u*k;
+         gu[old]--;
+         gu[bc]++;
+         if ( color[u] == old && gu[old] == 0 ) {
+            cv[pos[u]] = cv[--ncv];
+            pos[cv[ncv]] = pos[u];
+            pos[u] = -1;
+         } else if ( color[u] == bc && gu[bc] == 1 ) {
+            pos[u] = ncv;
+            cv[ncv++] = u;
+         }
+      }
+      if ( gamma[(size_t)bv*k + bc] == 0 ) {
+         cv[pos[bv]] = cv[--ncv];
+         pos[cv[ncv]] = pos[bv];
+         pos[bv] = -1;
+      }
+      f += bd;
+      tabu[(size_t)bv*k + old] = it + tc_rand(seed) % 10 + (6*ncv)/10;
+      if ( f < best_f )
+         best_f = f;
+   }
+   *iter += it;
+   found = (f == 0);
+
+   free(pos);
+   free(cv);
+   free(tabu);
+   free(gamma);
+   return found;
+}
+
+/// A run: TabuCol with one color less than the best coloring, until a run
+/// fails or the lower bound is reached
+static void* tc_run(void* arg) {
+   tc_shared_t*  S = ((tc_run_t*)arg)->S;
+   unsigned int  seed = ((tc_run_t*)arg)->seed;
+   int           n = S->n;
+   int          *color = (int*) malloc(n*sizeof(int));
+   int           v, k, found;
+   long          iter = 0;
+
+   if ( seed == 0 )
+      seed = 1;
+   while ( 1 ) {
+      pthread_mutex_lock(&S->lock);
+      k = S->best-1;
+      memcpy(color, S->color, n*sizeof(int));
+      pthread_mutex_unlock(&S->lock);
+      if ( k < S->opt->lb || k < 1 )
+         break;
+      /// The vertices of the last color get a random one
+      for ( v = 0; v < n; ++v )
+         if ( color[v] >= k )
+            color[v] = tc_rand(&seed) % k;
+      found = tc_tabucol(S, k, color, &seed, &iter);
+      pthread_mutex_lock(&S->lock);
+      if ( found && k < S->best ) {
+         S->best = k;
+         memcpy(S->color, color, n*sizeof(int));
+      }
+      if ( !found && S->best > k ) {
+         pthread_mutex_unlock(&S->lock);
+         break;
+      }
+      pthread_mutex_unlock(&S->lock);
+   }
+   pthread_mutex_lock(&S->lock);
+   S->opt->iter += iter;
+   pthread_mutex_unlock(&S->lock);
+   free(color);
+   return NULL;
+}
+
+int tc_color(int n, word_t* const* adj, int* color, tc_options_t* opt) {
+   tc_shared_t      S;
+   tc_options_t     tmp;
+   int              w = BS_WORDS(n);
+   int              v, u, t, m = 0;
+   pthread_t       *tid;
+   tc_run_t        *run;
+
+   if ( opt == NULL ) {
+      tmp.max_iter = 100000;
+      tmp.threads  = 1;
+      tmp.lb       = 0;
+      tmp.seed     = 13;
+      opt = &tmp;
+   }
+   opt->iter = 0;
+   if ( n == 0 ) {
+      opt->greedy = 0;
+      return 0;
+   }
+   opt->greedy = tc_dsatur(n, adj, color);
+
+   S.n = n;
+   S.opt = opt;
+   S.best = opt->greedy;
+   S.color = color;
+   S.start = (int*) malloc((n+1)*sizeof(int));
+   for ( v = 0; v < n; ++v ) {
+      S.start[v] = m;
+      m += bs_count(adj[v], w);
+   }
+   S.start[n] = m;
+   S.nbr = (int*) malloc((m+1)*sizeof(int));
+   for ( v = 0, m = 0; v < n; ++v )
+      for ( u = bs_next(adj[v], w, 0); u >= 0; u = bs_next(adj[v], w, u+1) )
+         S.nbr[m++] = u;
+   pthread_mutex_init(&S.lock, NULL);
+
+   if ( opt->threads < 1 )
+      opt->threads = 1;
+   tid  = (pthread_t*) malloc(opt->threads*sizeof(pthread_t));
+   run  = (tc_run_t*) malloc(opt->threads*sizeof(tc_run_t));
+   for ( t = 0; t < opt->threads; ++t ) {
+      run[t].S = &S;
+      run[t].seed = opt->seed + 7919*t;
+   }
+   if ( opt->threads == 1 )
+      tc_run(&run[0]);
+   else {
+      for ( t = 0; t < opt->threads; ++t )
+         pthread_create(&tid[t], NULL, tc_run, &run[t]);
+      for ( t = 0; t < opt->threads; ++t )
+         pthread_join(tid[t], NULL);
+   }
+
+   pthread_mutex_destroy(&S.lock);
+   free(run);
+   free(tid);
+   free(S.nbr);
+   free(S.start);
+   return S.best;
+}
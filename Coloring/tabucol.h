@@ -0,0 +1,47 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Upper bounds for graph coloring by local search. A greedy DSATUR
+ *  coloring (Brelaz) gives the first bound, then TabuCol (Hertz and de
+ *  Werra, with the dynamic tabu tenure of Galinier and Hao) looks for a
+ *  coloring with one color less, starting from the best coloring found so
+ *  far, until it runs out of iterations. TabuCol keeps the conflict matrix
+ *  gamma[v][c] (neighbours of v with color c) in flat arrays and updates it
+ *  incrementally after every move. Several runs with different seeds can
+ *  be done in parallel, sharing the best coloring. The library is written
+ *  in C and can be used from C++.
+ */
+
+#ifndef _TABUCOL_H_
+#define _TABUCOL_H_
+
+#include "bitset.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+   long          max_iter;  /* TabuCol iterations for each number of colors */
+   int           threads;   /* parallel runs, each with its own seed */
+   int           lb;        /* stop as soon as a coloring with lb colors is found */
+   unsigned int  seed;      /* seed of the first run */
+   int           greedy;    /* colors of the DSATUR coloring (written) */
+   long          iter;      /* TabuCol iterations of all the runs (written) */
+} tc_options_t;
+
+/// Greedy DSATUR coloring of the graph with 'n' vertices and adjacency rows
+/// 'adj' (bitsets of BS_WORDS(n) words, no loops): on return color[v] is in
+/// 0..k-1, and the number of colors k is returned
+int tc_dsatur(int n, word_t* const* adj, int* color);
+
+/// Best coloring found by DSATUR and TabuCol, with colors in 0..k-1: the
+/// number of colors k is returned. 'opt' may be NULL for the defaults
+int tc_color(int n, word_t* const* adj, int* color, tc_options_t* opt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TABUCOL_H_ */
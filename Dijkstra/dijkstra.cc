@@ -9,6 +9,7 @@ typedef int64_t    cost_t;
 
 /// From STL library
 #include <vector>
+#include <algorithm>
 using std::vector;
 
 #include <string>
@@ -60,7 +61,82 @@ class Arc {
 
 /// Forward and Backward star: intrusive list
 typedef std::vector<Arc>                 FSArcList;
+
+///--------------------------------------------------------------------------------
+/// Compressed forward star (enabled with -DCOMPRESSED_ARCS)
+/// The targets of each node are sorted and gap-encoded as varint (LEB128) bytes,
+/// the costs are varint-encoded in a separate stream. The first gap is taken
+/// with respect to the source node and it is zigzag encoded, since it can be negative.
+
+inline bool arcLess ( const Arc& a, const Arc& b ) { return a.w < b.w; }
+
+inline void putVarint ( vector<uint8_t>& B, uint64_t x ) {
+   while ( x >= 128 ) {
+      B.push_back( uint8_t(x | 128) );
+      x >>= 7;
+   }
+   B.push_back( uint8_t(x) );
+}
+
+inline uint64_t getVarint ( const uint8_t*& p ) {
+   uint64_t x = *p & 127;
+   int      s = 7;
+   while ( *p++ & 128 ) {
+      x |= uint64_t(*p & 127) << s;
+      s += 7;
+   }
+   return x;
+}
+
+inline uint64_t zigzag ( int64_t x )    { return (uint64_t(x) << 1) ^ uint64_t(x >> 63); }
+inline int64_t  unzigzag ( uint64_t x ) { return int64_t(x >> 1) ^ -int64_t(x & 1); }
+
+/// Decoding iterator over the compressed forward star of a node:
+/// it behaves as a FSArcList::iterator for the loop in 'spp'
+class CompressedArcIter {
+   private:
+      const uint8_t*  t;       /// Current arc in the target stream
+      const uint8_t*  t_next;  /// Next arc in the target stream
+      const uint8_t*  t_end;   /// End of the forward star in the target stream
+      const uint8_t*  c;       /// Next arc in the cost stream
+      Arc             a;       /// Current decoded arc
+
+      void decode( bool first ) {
+         if ( t == t_end )
+            return;
+         t_next = t;
+         if ( first )
+            a.w += node_t( unzigzag( getVarint(t_next) ) );
+         else
+            a.w += node_t( getVarint(t_next) );
+         a.c = cost_t( getVarint(c) );
+      }
+   public:
+      /// Standard constructor: 'u' is the source node
+      CompressedArcIter ( node_t u, const uint8_t* _t, const uint8_t* _t_end, const uint8_t* _c )
+         : t(_t), t_next(_t), t_end(_t_end), c(_c), a(u,0)
+      {
+         decode(true);
+      }
+      /// End iterator
+      explicit CompressedArcIter ( const uint8_t* _t_end )
+         : t(_t_end), t_next(_t_end), t_end(_t_end), c(NULL), a(0,0) {}
+
+      inline const Arc* operator->() const { return &a; }
+      inline const Arc& operator*() const { return a; }
+      inline bool operator!=( const CompressedArcIter& rhs ) const { return t != rhs.t; }
+      inline CompressedArcIter& operator++() {
+         t = t_next;
+         decode(false);
+         return *this;
+      }
+};
+
+#ifdef COMPRESSED_ARCS
+typedef CompressedArcIter                FSArcIter;
+#else
 typedef FSArcList::iterator              FSArcIter;
+#endif
 
 ///--------------------------------------------------------------------------------
 /// Class of graph to compute RCSP with superadditive cost
@@ -71,6 +147,13 @@ class Digraph {
 
       vector<FSArcList>  Nc;   /// Nodes container
 
+      /// Compressed forward stars: node 'u' owns bytes [Ft[u], Ft[u+1]) of T
+      /// and its costs start at byte Fc[u] of C
+      vector<uint32_t>   Ft;
+      vector<uint32_t>   Fc;
+      vector<uint8_t>    T;    /// Gap-encoded targets
+      vector<uint8_t>    C;    /// Varint-encoded costs
+
       /// Initialize distance vector with Infinity
       /// Maybe it is better to intialize with an upper bound on the optimal path (optimal rcsp path)
       const cost_t Inf;
@@ -94,6 +177,60 @@ class Digraph {
       void addArc( node_t i, node_t j, cost_t c ) {    
          Nc[i].push_back( Arc(j, c) );
       }
+
+      /// Build the compressed forward stars and release the arc lists
+      void compress() {
+         Ft.resize(n+1);
+         Fc.resize(n+1);
+         T.reserve(2*size_t(m));
+         C.reserve(3*size_t(m));
+         for ( node_t u = 0; u < n; ++u ) {
+            Ft[u] = uint32_t(T.size());
+            Fc[u] = uint32_t(C.size());
+            std::sort( Nc[u].begin(), Nc[u].end(), arcLess );
+            node_t prev = u;
+            for ( FSArcList::iterator it = Nc[u].begin(), it_end = Nc[u].end(); it != it_end; ++it ) {
+               assert( it->c >= 0 );
+               if ( it == Nc[u].begin() )
+                  putVarint( T, zigzag( int64_t(it->w) - prev ) );
+               else
+                  putVarint( T, uint64_t(it->w - prev) );
+               putVarint( C, uint64_t(it->c) );
+               prev = it->w;
+            }
+            FSArcList().swap(Nc[u]);
+         }
+         /// Offsets are 32 bits: each stream must stay below 4GB
+         if ( T.size() >= (size_t(1) << 32) || C.size() >= (size_t(1) << 32) ) {
+            fprintf(stderr, "compress: arc streams exceed 4GB, 32-bit offsets overflow\n");
+            exit ( EXIT_FAILURE );
+         }
+         Ft[n] = uint32_t(T.size());
+         Fc[n] = uint32_t(C.size());
+         vector<FSArcList>().swap(Nc);
+         vector<uint8_t>(T).swap(T);
+         vector<uint8_t>(C).swap(C);
+      }
+
+      /// Memory (in bytes) used to store the arcs
+      size_t memory() const {
+         size_t b = Nc.capacity()*sizeof(FSArcList);
+         for ( size_t i = 0; i < Nc.size(); ++i )
+            b += Nc[i].capacity()*sizeof(Arc);
+         b += (Ft.capacity() + Fc.capacity())*sizeof(uint32_t);
+         b += T.capacity() + C.capacity();
+         return b;
+      }
+
+#ifdef COMPRESSED_ARCS
+      inline FSArcIter arcsBegin( node_t u ) const {
+         return CompressedArcIter( u, T.data()+Ft[u], T.data()+Ft[u+1], C.data()+Fc[u] );
+      }
+      inline FSArcIter arcsEnd( node_t u ) const { return CompressedArcIter( T.data()+Ft[u+1] ); }
+#else
+      inline FSArcIter arcsBegin( node_t u ) { return Nc[u].begin(); }
+      inline FSArcIter arcsEnd( node_t u ) { return Nc[u].end(); }
+#endif
      
       ///--------------------------------------------------
       /// Shortest Path for a graph with positive weights
@@ -121,7 +258,7 @@ class Digraph {
             cost_t Du = -(*K[u]).d;
             if ( u == T ) { break; }
             /// for all edges (u, v) \in E
-            for ( FSArcIter it = Nc[u].begin(), it_end = Nc[u].end(); it != it_end; ++it ) {
+            for ( FSArcIter it = arcsBegin(u), it_end = arcsEnd(u); it != it_end; ++it ) {
                node_t v   = it->w;
                if ( Q[v] != SCANNED ) {
                   cost_t Duv = it->c;
@@ -180,6 +317,10 @@ cost_t runDijkstra( char* argv[] ) {
       infile >> v >> w >> c;
       G.addArc(v-1, w-1, c);
    }
+#ifdef COMPRESSED_ARCS
+   G.compress();
+#endif
+   fprintf(stdout,"Memory %.1f MB, %.2f bytes per arc\n", G.memory()/1048576.0, double(G.memory())/m);
    
    vector<node_t> P(n);
    cost_t T_dist; 
@@ -35,6 +35,9 @@ Es = ["rand_10000_100000","rand_10000_1000000","rand_10000_10000000"]
 Gs = ["dijkstra","dijkstra_bgl","dijkstra_lemon"]
 Hs = ["US-d.W", "US-d.E", "US-d.LKS", "US-d.CAL", "US-d.NE", "US-d.NW", "US-d.FLA", "US-d.COL", "US-d.BAY", "US-d.NY"] 
 Is = ["dijkstra_binary", "dijkstra_ternary", "dijkstra_skew", "dijkstra_lemon"]
+# There are no logs of dijkstra_compressed yet: add [Js,Hs] to the loop
+# below after running run_tests.bash on the US graphs
+Js = ["dijkstra_binary", "dijkstra_compressed"]
    
 for A,B in [[Fs,Es],[Gs,Hs],[Is,Hs]]:
     Ts = makeTable(A,B)
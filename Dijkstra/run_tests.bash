@@ -2,7 +2,7 @@
 
 SOLVERS_A="dijkstra dijkstra_bgl dijkstra_lemon dijkstra_or-tools"
 SOLVERS_B="dijkstra dijkstra_bgl dijkstra_lemon"
-SOLVERS_C="dijkstra_binary"
+SOLVERS_C="dijkstra_binary dijkstra_compressed"
 
 PATH_DATA="/Users/stegua/MyDATA/dimacs-shortestpath"
 FILES_A="rand_10000_100000.dat rand_10000_1000000.dat rand_10000_10000000.dat"
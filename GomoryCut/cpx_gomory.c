@@ -1,6 +1,6 @@
 /********************************************************************************
 
-Spaghetti Optimization - Gomory Cuts using CPLEX callable library
+Spaghetti Optimization - Gomory Cuts using a dual simplex (lp.h)
 
 Stefano Gualandi, stefano.gualandi [at] gmail.com
 
@@ -39,16 +39,22 @@ Stefano Gualandi, stefano.gualandi [at] gmail.com
      x_i >= 0 and integer for i in {1,2}  (x_3, x_4, and x_5 are slacks)
 */
 
-#include <ilcplex/cplex.h>
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS   /// fopen and fscanf
+#endif
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
 
+#include "lp.h"
+#include "cutloop.h"
+#include "mip.h"
+
 #define TRUE   0
 #define FALSE  1
-#define MAX_N_ROWS 20
+#define MAX_PRINT 20   /// Larger problems are not printed
 #define POST_CMD(x) if (x) goto QUIT;
 
 /// From IBM-ILOG examples
@@ -60,62 +66,19 @@ free_and_null (char **ptr) {
    }
 } /* END free_and_null */
 
-/// My Rows structure to store cutting planes
-/// First row is the cost vector (i.e. rhs=0)
-typedef struct {
-   int     n;
-   double  rhs;
-   int*    ind;
-   double* lhs;
-} MyRow;
+/// Why the cutting plane loop stopped (GC_INTEGER, ...)
+static const char* gc_status_msg[] = {
+   "Integer solution", "No cuts", "Stall", "Rounds limit", "LP failed"
+};
 
-int isInteger(int n, const double* x) {
+int isInteger(int n, const double* x, const char* is_int) {
    int i = 0;
    for ( i = 0; i < n; ++i )
-      if ( fabs(round(x[i])) - x[i] > 1e-05 )
+      if ( is_int[i] && fabs(round(x[i]) - x[i]) > 1e-05 )
          return TRUE;
    return FALSE;
 }
 
-int read_matrix(const char* filename, MyRow* rows) {
-   int i = 0, j = 0;
-   int n = 0, m = 0;
-   FILE *in = NULL;
-   errno_t err;
-
-   if ((err = fopen_s(&in, filename, "r")) != 0) {
-      fprintf(stdout, "Impossible to open file: %s\n", filename);
-      exit(EXIT_FAILURE);
-   }
-
-   /// Read the number of variables and constraints
-   /// of the first problem
-   fscanf_s(in, "%d %d", &n, &m);
-   /// Add the cost vector as first row
-   rows[0].n = n;
-   rows[0].ind = (int*)    malloc (n * sizeof(int));
-   rows[0].lhs = (double*) malloc (n * sizeof(double));
-   for ( j = 0; j < n; ++j ) {
-      rows[0].ind[j] = j;
-      fscanf_s(in, "%lf", &rows[0].lhs[j] );
-   }
-   fscanf_s(in, "%lf", &rows[0].rhs );
-   /// Read the matrix row A_i and rhs b_i
-   for ( i = 1; i < m; ++i ) {
-      rows[i].n   = n;
-      rows[i].ind = (int*)    malloc (n * sizeof(int));
-      rows[i].lhs = (double*) malloc (n * sizeof(double));
-      for ( j = 0; j < n; ++j ) {
-         rows[i].ind[j] = j;
-         fscanf_s(in, "%lf", &rows[i].lhs[j] );
-      }
-      fscanf_s(in, "%lf", &rows[i].rhs );
-   }
-   fclose(in);
-
-   return m;
-}
-
 void print_solution(int cur_numcols, const double* x, const int* cstat) {
    int j = 0;
    char* basismsg = NULL;
@@ -124,16 +87,16 @@ void print_solution(int cur_numcols, const double* x, const int* cstat) {
       printf ( "x%d = %.2lf", j+1, x[j]);
       if ( cstat != NULL ) {
          switch (cstat[j]) {
-         case CPX_AT_LOWER:
+         case LP_AT_LOWER:
             basismsg = "Nonbasic at lower bound";
             break;
-         case CPX_BASIC:
+         case LP_BASIC:
             basismsg = "Basic";
             break;
-         case CPX_AT_UPPER:
+         case LP_AT_UPPER:
             basismsg = "Nonbasic at upper bound";
             break;
-         case CPX_FREE_SUPER:
+         case LP_FREE_SUPER:
             basismsg = "Superbasic, or free variable at zero";
             break;
          default:
@@ -146,312 +109,279 @@ void print_solution(int cur_numcols, const double* x, const int* cstat) {
    }
 }
 
-void print_max_lp(int m, const MyRow* rows) {
-   int i = 0, j = 0;
+/// Only the nonzero coefficients are printed
+void print_max_lp(const mip_t* P) {
+   int i = 0, j = 0, p = 0;
    printf("min ");
-   for ( j = 0; j < rows[0].n; ++j ) {
-      if ( rows[i].lhs[j] >= 0 )
-         printf("+");
-      printf("%.1f x%d ", rows[0].lhs[j], rows[0].ind[j] + 1);
-   }
+   for ( j = 0; j < P->n; ++j )
+      if ( P->obj[j] != 0 ) {
+         if ( P->obj[j] >= 0 )
+            printf("+");
+         printf("%.1f x%d ", P->obj[j], j + 1);
+      }
    printf("\n");
-   for ( i = 1; i < m; ++i ) {
-      for ( j = 0; j < rows[i].n; ++j ) {
-         if ( rows[i].lhs[j] >= 0 )
+   for ( i = 0; i < P->m; ++i ) {
+      for ( p = P->rbeg[i]; p < P->rbeg[i+1]; ++p ) {
+         if ( P->rval[p] >= 0 )
             printf("+");
-         printf("%1.1f x%d ", rows[i].lhs[j], rows[i].ind[j] + 1);
+         printf("%1.1f x%d ", P->rval[p], P->rind[p] + 1);
       }
-      printf("<= %2.1f\n", rows[i].rhs);
+      printf("%s %2.1f\n", P->sense[i] == 'L' ? "<=" : P->sense[i] == 'G' ? ">=" : "=", P->rhs[i]);
    }
-   for ( j = 0; j < rows[0].n; ++j ) {
-      printf("x%d >= 0\t", j + 1);
+   for ( j = 0; j < P->n; ++j ) {
+      if ( P->lb[j] > -MIP_INFINITY )
+         printf("x%d >= %g", j + 1, P->lb[j]);
+      else
+         printf("x%d free", j + 1);
+      if ( P->ub[j] < MIP_INFINITY )
+         printf(", <= %g", P->ub[j]);
+      printf("\t");
    }
    printf("\n");
 }
 
-int cg_solver(int m, MyRow* rows) {
-   CPXENVptr     env = NULL;
-   CPXLPptr      model = NULL;
+int cg_solver(const mip_t* P, const gc_params_t* par) {
+   lp_t*         model = NULL;
    int           status = 0;
-   int           error = 0;
-   int           i, j;
+   int           i, j, p;
    int           cur_numrows, cur_numcols;
-   int           n_cuts, cut;
 
    int       solstat;
    double    objval;
-   double   *x;
-   double   *z;
-   int      *cstat;
+   double   *x = NULL;
+   double   *z = NULL;
+   int      *cstat = NULL;
 
-   int      n0 = rows[0].n;
-   int      n1 = rows[0].n+m-1;  /// One slack variable for constraint
-   int      h = (m-1)*n0 + m-1;  /// Number of nonzeros
+   int      n0 = P->n;
+   int      n1 = P->n;           /// One slack variable per inequality
+   int      h = P->nz + P->m;    /// Number of nonzeros
 
-   double*  obj = (double*)malloc(n1*sizeof(double));
+   double*  obj = (double*)malloc((n0+P->m)*sizeof(double));
+   double*  lb = (double*)malloc((n0+P->m)*sizeof(double));
+   double*  ub = (double*)malloc((n0+P->m)*sizeof(double));
 
-   double*   rhs = (double*)malloc((m-1) * sizeof(double));    /// The first row is for the cost vector
-   char*    sense = (char*)malloc((m-1) * sizeof(char));
+   char*    sense = (char*)malloc(P->m * sizeof(char));
 
    int*     jnd = (int*)malloc(h * sizeof(int));
    int*     ind = (int*)malloc(h * sizeof(int));
    double*  val = (double*)malloc(h * sizeof(double));
 
    int      idx = 0;
+   int      small = 0;
 
-   int*     rmatbeg;
-   int*     rmatind;
-   double*  rmatval;
-   double*  b_bar;
-   char*    gc_sense;
-   double*  gc_rhs;
-
-   /// Create environment
-   env = CPXopenCPLEX (&status);
-   if ( env == NULL ) {
-      char  errmsg[CPXMESSAGEBUFSIZE];
-      fprintf (stderr, "Could not open CPLEX environment. Status: %d\n", status);
-      CPXgeterrorstring (env, status, errmsg);
-      fprintf (stderr, "%s", errmsg);
-      goto QUIT;
-   }
+   double*  b_bar = NULL;
+   char*    is_int = NULL;
+   gc_stats_t stats;
 
-   /// Disable presolve
-   POST_CMD( CPXsetintparam (env, CPX_PARAM_PREIND, CPX_OFF) );
+   /// Create problem (a minimization problem, without presolve)
+   model = lp_new();
 
-   /// Create problem
-   model = CPXcreateprob (env, &error, "gomory");
-   if (error) goto QUIT;
-
-   /// Minimization problem
-   POST_CMD( CPXchgobjsen (env, model, CPX_MIN) );
-
-   /// Add rows (remember first row is cost vector)
-   for ( i = 0; i < m-1; ++i ) {
+   /// Add rows, as equations with the slack variables
+   for ( i = 0; i < P->m; ++i )
       sense[i]='E';
-      rhs[i] = rows[i+1].rhs;
-   }
-   POST_CMD( CPXnewrows(env, model, m-1, rhs, sense, NULL, NULL) );
+   POST_CMD( lp_new_rows(model, P->m, P->rhs, sense) );
 
    /// Add problem variables
-   for ( j = 0; j < n0; ++j )
-      obj[j] = rows[0].lhs[j];
+   for ( j = 0; j < n0; ++j ) {
+      obj[j] = P->obj[j];
+      lb[j] = P->lb[j];
+      ub[j] = P->ub[j];
+   }
    /// Add slack variables
-   for ( j = n0; j < n1; ++j )
-      obj[j] = 0;
-   POST_CMD( CPXnewcols(env, model, n1, obj, NULL, NULL, NULL, NULL) );
-
-   /// Write the full matrix A into the LP (WARNING: should use only nonzeros entries)
-   for ( i = 1; i < m; ++i ) {
-      for ( j = 0; j < n0; ++j ) {
-         jnd[idx] = i-1;
-         ind[idx] = rows[i].ind[j];
-         val[idx] = rows[i].lhs[j];
+   for ( i = 0; i < P->m; ++i )
+      if ( P->sense[i] != 'E' ) {
+         obj[n1] = 0;
+         lb[n1] = 0;
+         ub[n1++] = LP_INFINITY;
+      }
+   POST_CMD( lp_new_cols(model, n1, obj, lb, ub) );
+
+   /// Write the nonzero entries of A into the LP, and the slack variables
+   /// (+s for '<=', -s for '>=')
+   is_int = (char*) malloc(n1 * sizeof(char));
+   for ( j = 0; j < n0; ++j )
+      is_int[j] = P->is_int[j];
+   for ( i = 0, j = n0; i < P->m; ++i ) {
+      int integral = (floor(P->rhs[i]) == P->rhs[i]);
+      for ( p = P->rbeg[i]; p < P->rbeg[i+1]; ++p ) {
+         jnd[idx] = i;
+         ind[idx] = P->rind[p];
+         val[idx] = P->rval[p];
          idx++;
+         if ( !P->is_int[P->rind[p]] || floor(P->rval[p]) != P->rval[p] )
+            integral = 0;
+      }
+      if ( P->sense[i] != 'E' ) {
+         jnd[idx] = i;
+         ind[idx] = j;
+         val[idx] = (P->sense[i] == 'L') ? 1.0 : -1.0;
+         idx++;
+         /// The slack of a row with integer coefficients and variables
+         is_int[j++] = (char) integral;
       }
-      /// Add a slack variable per constraint
-      jnd[idx] = i-1;
-      ind[idx] = n0+i-1;
-      val[idx] = 1.0;
-      idx++;
    }
-   POST_CMD( CPXchgcoeflist(env, model, idx, jnd, ind, val) );
+   POST_CMD( lp_chg_coef_list(model, idx, jnd, ind, val) );
 
    /// Optimize the problem
-   POST_CMD( CPXlpopt(env, model) );
+   lp_optimize(model);
 
    /// Check the results
-   cur_numrows = CPXgetnumrows (env, model);
-   cur_numcols = CPXgetnumcols (env, model);
+   cur_numrows = lp_num_rows(model);
+   cur_numcols = lp_num_cols(model);
+   small = (cur_numrows <= MAX_PRINT && cur_numcols <= MAX_PRINT);
 
    x =  (double *) malloc (cur_numcols * sizeof(double));
-   z =  (double *) malloc (cur_numcols * sizeof(double));
+   z =  (double *) malloc ((cur_numcols + cur_numrows) * sizeof(double));
    cstat = (int *) malloc (cur_numcols * sizeof(int));
 
    b_bar = (double *) malloc (cur_numrows * sizeof(double));
 
-   POST_CMD( CPXsolution (env, model, &solstat, &objval, x, NULL, NULL, NULL) );
-   if ( solstat != 1 ) {
+   lp_solution(model, &solstat, &objval, x, NULL, NULL, NULL);
+   if ( solstat != LP_OPTIMAL ) {
       printf("The solver did not find an optimal solution\nSolver status code: %d\n",solstat);
       exit(0);
    }
 
    /// Write the output to the screen
    printf ("\nSolution status = %d\t\t", solstat);
-   printf ("Solution value  = %f\n\n", objval);
+   printf ("Solution value  = %f\n\n", objval + P->obj_offset);
 
    /// If the solution is integer, is the optimum -> exit the loop
-   if ( isInteger(cur_numcols, x) ) {
+   if ( isInteger(cur_numcols, x, is_int) ) {
       fprintf(stdout,"The solution is already integer!\n");
       goto QUIT;
    }
 
    /// Dump the problem model to 'gomory.lp' for debbuging
-   POST_CMD( CPXwriteprob(env, model, "gomory.lp", NULL) );
+   POST_CMD( lp_write(model, "gomory.lp") );
 
-   /// Get the base statuses
-   POST_CMD( CPXgetbase(env, model, cstat, NULL) );
+   if ( small ) {
+      /// Get the base statuses
+      POST_CMD( lp_get_base(model, cstat, NULL) );
 
-   print_solution(cur_numcols, x, cstat);
+      print_solution(cur_numcols, x, cstat);
 
-   printf("\nOptimal base inverted matrix:\n");
-   for ( i = 0; i < cur_numrows; ++i ) {
-      b_bar[i] = 0;
-      POST_CMD( CPXbinvrow(env, model, i, z) );
-      for ( j = 0; j < cur_numrows; ++j ) {
-         printf("%.1f ", z[j]);
-         b_bar[i] += z[j]*rhs[j];
+      printf("\nOptimal base inverted matrix:\n");
+      for ( i = 0; i < cur_numrows; ++i ) {
+         POST_CMD( lp_binvrow(model, i, z) );
+         for ( j = 0; j < cur_numrows; ++j )
+            printf("%.1f ", z[j]);
+         printf("\n");
       }
-      printf("\n");
-   }
 
-   printf("\nOptimal solution (non basic variables are equal to zero):\n");
-   idx = 0;     /// Compute the nonzeros
-   n_cuts = 0;  /// Number of fractional variables (cuts to be generated)
-   for ( i = 0; i < m-1; ++i ) {
-      POST_CMD( CPXbinvarow(env, model, i, z) );
-      for ( j = 0; j < n1; ++j ) {
-         if ( z[j] >= 0 )
-            printf("+");
-         printf("%.1f x%d ", z[j], j+1);
-         if ( floor(z[j]+0.5) != 0 )
-            idx++;
-      }
-      printf("= %.1f\n", b_bar[i]);
-      /// Count the number of cuts to be generated
-      if ( floor(b_bar[i]) != b_bar[i] )
-         n_cuts++;
-   }
+      /// The values of the basic variables
+      POST_CMD( lp_get_bhead(model, NULL, b_bar) );
 
-   /// Allocate memory for the new data structure
-   gc_sense = (char*)   malloc ( n_cuts * sizeof(char) );
-   gc_rhs   = (double*) malloc ( n_cuts * sizeof(double) );
-   rmatbeg  = (int*)    malloc ( n_cuts * sizeof(int) );
-   rmatind  = (int*)    malloc (    idx * sizeof(int) );
-   rmatval  = (double*) malloc (    idx * sizeof(double) );
-
-   printf("\nGenerate Gomory cuts:\n");
-   idx = 0;
-   cut = 0;  /// Index of cut to be added
-   for ( i = 0; i < m-1; ++i )
-      if ( floor(b_bar[i]) != b_bar[i] ) {
-         printf("Row %d gives cut ->   ", i+1);
-         POST_CMD( CPXbinvarow(env, model, i, z) );
-         rmatbeg[cut] = idx;
+      printf("\nOptimal solution (non basic variables are equal to zero):\n");
+      for ( i = 0; i < cur_numrows; ++i ) {
+         POST_CMD( lp_binvarow(model, i, z) );
          for ( j = 0; j < n1; ++j ) {
-            z[j] = floor(z[j]); /// DANGER!
-            if ( z[j] != 0 ) {
-               rmatind[idx] = j;
-               rmatval[idx] = z[j];
-               idx++;
-            }
-            /// Print the cut
             if ( z[j] >= 0 )
                printf("+");
             printf("%.1f x%d ", z[j], j+1);
          }
-         gc_rhs[cut] = floor(b_bar[i]); /// DANGER!
-         gc_sense[cut] = 'L';
-         printf("<= %.1f\n", gc_rhs[cut]);
-         cut++;
+         printf("= %.1f\n", b_bar[i]);
       }
+   }
 
-   /// Add the new cuts
-   POST_CMD( CPXaddrows (env, model, 0,
-                         n_cuts, idx, gc_rhs, gc_sense,
-                         rmatbeg, rmatind, rmatval,
-                         NULL, NULL) );
-
-   /// Solve the new LP
-   POST_CMD( CPXlpopt(env, model) );
+   /// Rounds of Gomory cuts, each solved from the basis of the previous one
+   printf("\nGomory cutting plane loop:\n");
+   gc_cut_loop(model, is_int, par, &stats);
+   printf("\n%s after %d rounds: bound %f (LP %f), cuts %ld generated, %ld added, %ld removed, %d in LP\n",
+          gc_status_msg[stats.status], stats.rounds, stats.bound + P->obj_offset,
+          stats.lp_bound + P->obj_offset, stats.generated, stats.added, stats.removed, stats.in_lp);
 
    /// Check the results
-   cur_numrows = CPXgetnumrows (env, model);
-   cur_numcols = CPXgetnumcols (env, model);
+   cur_numrows = lp_num_rows(model);
+   cur_numcols = lp_num_cols(model);
 
-   POST_CMD( CPXsolution (env, model, &solstat, &objval, x, NULL, NULL, NULL) );
+   lp_solution(model, &solstat, &objval, x, NULL, NULL, NULL);
 
-   if ( solstat != 1 ) {
+   if ( solstat != LP_OPTIMAL ) {
       printf("The solver did not find an optimal solution\nSolver status code: %d\n",solstat);
       exit(0);
    }
    /// Write the output to the screen
    printf ("\nSolution status = %d\n", solstat);
-   printf ("Solution value = %f\n\n", objval);
+   printf ("Solution value = %f\n\n", objval + P->obj_offset);
 
-   POST_CMD( CPXgetbase(env, model, cstat, NULL) );
+   if ( small ) {
+      POST_CMD( lp_get_base(model, cstat, NULL) );
 
-   print_solution(cur_numcols, x, cstat);
-
-   free_and_null ((char **) &x);
-   free_and_null ((char **) &z);
-   free_and_null ((char **) &cstat);
-   free_and_null ((char **) &rmatbeg);
-   free_and_null ((char **) &rmatind);
-   free_and_null ((char **) &rmatval);
+      print_solution(cur_numcols, x, cstat);
+   }
 
 QUIT:
    free_and_null ((char **) &x);
    free_and_null ((char **) &z);
    free_and_null ((char **) &cstat);
+   free_and_null ((char **) &b_bar);
+   free_and_null ((char **) &is_int);
 
-   free(rhs);
+   free(obj);
+   free(lb);
+   free(ub);
    free(sense);
 
    free(jnd);
    free(ind);
    free(val);
 
-   if ( error ) {
-      char  errmsg[CPXMESSAGEBUFSIZE];
-      CPXgeterrorstring (env, error, errmsg);
-      fprintf (stderr, "%s", errmsg);
-   }
-
-   /* Free up the problem as allocated by CPXcreateprob, if necessary */
-   if ( model != NULL ) {
-      status = CPXfreeprob (env, &model);
-      if ( status ) {
-         fprintf (stderr, "CPXfreeprob failed, error code %d.\n", status);
-      }
-   }
-
-   /* Free up the CPLEX environment, if necessary */
-   if ( env != NULL ) {
-      status = CPXcloseCPLEX (&env);
-
-      if ( error ) {
-         char  errmsg[CPXMESSAGEBUFSIZE];
-         fprintf (stderr, "Could not close CPLEX environment.\n");
-         CPXgeterrorstring (env, status, errmsg);
-         fprintf (stderr, "%s", errmsg);
-      }
-   }
+   lp_free(model);
 
    return (status);
 }
 
 int main(int argc, char* argv[]) {
-   MyRow rows[MAX_N_ROWS];
+   mip_t*  P = NULL;
+   gc_params_t par;
+   size_t  len = 0;
    int i = 0;
 
-   if (argc != 2) {
+   /// Options: -r rounds, -c cuts per round, -g (Gomory mixed integer cuts),
+   /// -v verbosity (2 prints the cuts: the default for small problems)
+   gc_default_params(&par);
+   par.verbose = -1;
+   for ( i = 1; i < argc-1 && argv[i][0] == '-'; ++i ) {
+      if ( argv[i][1] == 'g' )
+         par.gmi = 1;
+      else if ( i+1 < argc-1 && argv[i][1] == 'r' )
+         par.max_rounds = atoi(argv[++i]);
+      else if ( i+1 < argc-1 && argv[i][1] == 'c' )
+         par.max_cuts = atoi(argv[++i]);
+      else if ( i+1 < argc-1 && argv[i][1] == 'v' )
+         par.verbose = atoi(argv[++i]);
+      else
+         break;
+   }
+   if (i != argc-1) {
 #ifdef _WIN32
-      fprintf(stdout, "\nUsage:\n GomoryCut.exe example.mat\n\n");
+      fprintf(stdout, "\nUsage:\n GomoryCut.exe [-r rounds] [-c cuts] [-g] [-v level] example.mat|problem.mps\n\n");
 #else
-      fprintf(stdout, "\nUsage:\n cg_solver example.mat\n\n");
+      fprintf(stdout, "\nUsage:\n cg_solver [-r rounds] [-c cuts] [-g] [-v level] example.mat|problem.mps\n\n");
 #endif
       exit(EXIT_FAILURE);
    }
 
-   int m = read_matrix(argv[1], rows);
-   print_max_lp(m, rows);
-   cg_solver(m, rows);
+   /// The files ending in ".mps" are in MPS format
+   len = strlen(argv[i]);
+   if ( len > 4 && (strcmp(argv[i]+len-4, ".mps") == 0 || strcmp(argv[i]+len-4, ".MPS") == 0) )
+      P = mip_read_mps(argv[i]);
+   else
+      P = mip_read_mat(argv[i]);
+   if ( P == NULL )
+      exit(EXIT_FAILURE);
+
+   if ( P->n <= MAX_PRINT && P->m <= MAX_PRINT )
+      print_max_lp(P);
+   else
+      printf("Problem %s: %d rows, %d columns, %d nonzeros%s\n", P->name, P->m, P->n, P->nz,
+             P->maximize ? " (maximization, solved as min -cx)" : "");
+   if ( par.verbose < 0 )
+      par.verbose = (P->n <= MAX_PRINT && P->m <= MAX_PRINT) ? 2 : 1;
+   cg_solver(P, &par);
 
-   for ( i = 0; i < m; ++i ) {
-      free(rows[i].lhs);
-      free(rows[i].ind);
-   }
+   mip_free(P);
 
    return 0;
-}
\ No newline at end of file
+}
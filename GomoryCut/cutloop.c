@@ -0,0 +1,535 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Cutting plane loop with Gomory cuts (see cutloop.h)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "cutloop.h"
+
+#define EPS_ZERO     1e-11   /* tableau entries taken as zero */
+#define EPS_INT      1e-6    /* integrality of the LP solution */
+#define EPS_RELAX    1e-9    /* relative relaxation of the right hand side */
+
+/// A cut val x >= rhs, in the space of the columns
+typedef struct {
+   int     nz;
+   int    *ind;
+   double *val;
+   double  rhs;
+   double  norm;
+   double  eff;    /* efficacy at the current LP solution */
+   int     age;
+   int     row;    /* row of the LP, or -1 if only in the pool */
+   int     fresh;  /* derived in this round, not yet in the pool */
+} cut_t;
+
+typedef struct {
+   lp_t*              lp;
+   const char*        is_int;
+   const gc_params_t* par;
+   int                n, m0;
+   double            *lb, *ub;
+   /// Rows of the LP without cuts, and the integrality of their logicals
+   int               *rbeg, *rind;
+   double            *rval, *rhs;
+   char              *sense, *int_row;
+   /// All the cuts, and the cut of every row m0+k of the LP
+   cut_t            **pool;
+   int                npool;
+   cut_t            **lp_cut;
+   int                nlp;
+   /// Scratch: x has n entries, and the vectors of m entries grow with m
+   int                mcap;
+   double            *x, *alpha, *pi, *dense, *beta, *xb;
+   int               *cstat, *rstat, *head, *touched;
+   char              *mark;
+} gc_t;
+
+void gc_default_params(gc_params_t* par) {
+   par->max_rounds   = 50;
+   par->max_cuts     = 50;
+   par->min_efficacy = 1e-5;
+   par->max_parallel = 0.98;
+   par->min_away     = 0.01;
+   par->max_dynamism = 1e6;
+   par->max_age      = 3;
+   par->pool_age     = 10;
+   par->stall_rounds = 5;
+   par->stall_tol    = 1e-5;
+   par->gmi          = 0;
+   par->verbose      = 1;
+}
+
+static void cut_free(cut_t* c) {
+   free(c->ind);
+   free(c->val);
+   free(c);
+}
+
+/// Integer variable with an integer bound
+static int is_integral(double v) {
+   return fabs(v - floor(v + 0.5)) < EPS_ZERO;
+}
+
+static void gc_init(gc_t* G, lp_t* lp, const char* is_int, const gc_params_t* par) {
+   int i, j, p, nz = 0;
+   memset(G, 0, sizeof(gc_t));
+   G->lp = lp;
+   G->is_int = is_int;
+   G->par = par;
+   G->n = lp_num_cols(lp);
+   G->m0 = lp_num_rows(lp);
+   G->lb = (double*) malloc(G->n*sizeof(double));
+   G->ub = (double*) malloc(G->n*sizeof(double));
+   lp_get_bounds(lp, G->lb, G->ub);
+   G->rhs = (double*) malloc((G->m0+1)*sizeof(double));
+   G->sense = (char*) malloc((G->m0+1)*sizeof(char));
+   G->int_row = (char*) malloc((G->m0+1)*sizeof(char));
+   lp_get_rhs(lp, G->rhs, G->sense);
+   G->x = (double*) malloc(G->n*sizeof(double));
+   G->alpha = (double*) malloc(G->n*sizeof(double));
+   G->pi = (double*) malloc(G->n*sizeof(double));
+   G->dense = (double*) calloc(G->n, sizeof(double));
+   G->cstat = (int*) malloc(G->n*sizeof(int));
+   G->touched = (int*) malloc(G->n*sizeof(int));
+   G->mark = (char*) calloc(G->n, sizeof(char));
+   /// Copy of the rows: the logical of a row is integer if the row has
+   /// integer coefficients on integer columns, and an integer rhs
+   G->rbeg = (int*) malloc((G->m0+1)*sizeof(int));
+   for ( i = 0; i < G->m0; ++i )
+      nz += lp_get_row(lp, i, G->touched, G->alpha);
+   G->rind = (int*) malloc((nz > 0 ? nz : 1)*sizeof(int));
+   G->rval = (double*) malloc((nz > 0 ? nz : 1)*sizeof(double));
+   for ( i = 0, nz = 0; i < G->m0; ++i ) {
+      G->rbeg[i] = nz;
+      nz += lp_get_row(lp, i, G->rind + nz, G->rval + nz);
+      G->int_row[i] = is_integral(G->rhs[i]);
+      for ( p = G->rbeg[i]; p < nz; ++p ) {
+         j = G->rind[p];
+         if ( !is_int[j] || !is_integral(G->rval[p]) )
+            G->int_row[i] = 0;
+      }
+   }
+   G->rbeg[G->m0] = nz;
+   G->pool = (cut_t**) malloc(sizeof(cut_t*));
+   G->lp_cut = (cut_t**) malloc(sizeof(cut_t*));
+}
+
+static void gc_free(gc_t* G) {
+   int i;
+   for ( i = 0; i < G->npool; ++i )
+      cut_free(G->pool[i]);
+   free(G->pool); free(G->lp_cut);
+   free(G->lb); free(G->ub);
+   free(G->rbeg); free(G->rind); free(G->rval);
+   free(G->rhs); free(G->sense); free(G->int_row);
+   free(G->x); free(G->alpha); free(G->pi); free(G->dense);
+   free(G->beta); free(G->xb); free(G->cstat); free(G->rstat); free(G->head);
+   free(G->touched); free(G->mark);
+}
+
+/// Room for the vectors of m entries
+static void gc_resize(gc_t* G, int m) {
+   if ( m <= G->mcap )
+      return;
+   G->mcap = 2*m;
+   G->beta = (double*) realloc(G->beta, G->mcap*sizeof(double));
+   G->xb = (double*) realloc(G->xb, G->mcap*sizeof(double));
+   G->rstat = (int*) realloc(G->rstat, G->mcap*sizeof(int));
+   G->head = (int*) realloc(G->head, G->mcap*sizeof(int));
+}
+
+/// pi[j] += v, keeping the list of the entries touched
+static void add_pi(gc_t* G, int* nt, int j, double v) {
+   if ( !G->mark[j] ) {
+      G->mark[j] = 1;
+      G->pi[j] = 0;
+      G->touched[(*nt)++] = j;
+   }
+   G->pi[j] += v;
+}
+
+/// Coefficient in the cut (sum g x' >= 1) of a nonbasic variable x' >= 0,
+/// with tableau entry a
+static double gomory_coef(const gc_t* G, double a, int integer, double f0) {
+   if ( integer ) {
+      double f = a - floor(a);
+      if ( f < EPS_ZERO )
+         return 0;
+      if ( G->par->gmi && f > f0 )
+         return (1-f)/(1-f0);
+      return f/f0;
+   }
+   return (a > 0) ? a/f0 : -a/(1-f0);
+}
+
+/// Gomory cut from the tableau row of the basis position r, whose basic
+/// variable has value xb: NULL if the cut is unsafe or not violated
+static cut_t* gomory_cut(gc_t* G, int r, double xb) {
+   const gc_params_t* par = G->par;
+   int     n = G->n, m = lp_num_rows(G->lp), i, j, p, nt = 0, nz, free_var = 0;
+   double  f0 = xb - floor(xb), rhs = 1, amax = 0, amin, viol, norm;
+   cut_t*  c;
+
+   if ( lp_binvrow(G->lp, r, G->beta) != 0 || lp_binvarow(G->lp, r, G->alpha) != 0 )
+      return NULL;
+   /// Columns: x' = x - l at the lower bound, x' = u - x at the upper one
+   for ( j = 0; j < n; ++j ) {
+      double a = G->alpha[j], g;
+      int    s = G->cstat[j];
+      if ( s == LP_BASIC || fabs(a) < EPS_ZERO || G->lb[j] == G->ub[j] )
+         continue;
+      if ( s == LP_FREE_SUPER ) {   /// No bound to derive the cut from
+         free_var = 1;
+         break;
+      }
+      if ( s == LP_AT_LOWER ) {
+         g = gomory_coef(G, a, G->is_int[j] && is_integral(G->lb[j]), f0);
+         add_pi(G, &nt, j, g);
+         rhs += g*G->lb[j];
+      } else {
+         g = gomory_coef(G, -a, G->is_int[j] && is_integral(G->ub[j]), f0);
+         add_pi(G, &nt, j, -g);
+         rhs -= g*G->ub[j];
+      }
+   }
+   /// Logicals: s_i = b_i - a_i x, at the bound 0 (lower for the rows 'L',
+   /// upper for the rows 'G', which include the cuts)
+   for ( i = 0; i < m && !free_var; ++i ) {
+      double a = G->beta[i], g, b;
+      int    s = G->rstat[i];
+      if ( s == LP_BASIC || fabs(a) < EPS_ZERO || (i < G->m0 && G->sense[i] == 'E') )
+         continue;
+      if ( s == LP_AT_LOWER )
+         g = gomory_coef(G, a, i < G->m0 && G->int_row[i], f0);
+      else
+         g = -gomory_coef(G, -a, i < G->m0 && G->int_row[i], f0);
+      if ( g == 0 )
+         continue;
+      if ( i < G->m0 ) {
+         b = G->rhs[i];
+         for ( p = G->rbeg[i]; p < G->rbeg[i+1]; ++p )
+            add_pi(G, &nt, G->rind[p], -g*G->rval[p]);
+      } else {
+         cut_t* k = G->lp_cut[i - G->m0];
+         b = k->rhs;
+         for ( p = 0; p < k->nz; ++p )
+            add_pi(G, &nt, k->ind[p], -g*k->val[p]);
+      }
+      rhs -= g*b;
+   }
+   for ( p = 0; p < nt; ++p ) {
+      G->mark[G->touched[p]] = 0;
+      if ( fabs(G->pi[G->touched[p]]) > amax )
+         amax = fabs(G->pi[G->touched[p]]);
+   }
+   if ( free_var || amax == 0 )
+      return NULL;
+   /// Safety: a coefficient below amax/max_dynamism goes, relaxing the rhs
+   /// with the bound of its variable; without that bound, it grows to
+   /// amax/max_dynamism, relaxing the rhs with the other bound (the cut
+   /// val x >= rhs stays valid). Only those of the free variables are left
+   /// to the ratio test
+   amin = amax;
+   for ( p = 0, nz = 0; p < nt; ++p ) {
+      double v = G->pi[j = G->touched[p]], tiny = amax/par->max_dynamism;
+      if ( v == 0 )
+         continue;
+      if ( fabs(v) < tiny ) {
+         if ( v > 0 && G->ub[j] < LP_INFINITY ) {
+            rhs -= v*G->ub[j];
+            continue;
+         }
+         if ( v < 0 && G->lb[j] > -LP_INFINITY ) {
+            rhs -= v*G->lb[j];
+            continue;
+         }
+         if ( v > 0 && G->lb[j] > -LP_INFINITY ) {
+            rhs += (tiny - v)*G->lb[j];
+            G->pi[j] = v = tiny;
+         } else if ( v < 0 && G->ub[j] < LP_INFINITY ) {
+            rhs += (-tiny - v)*G->ub[j];
+            G->pi[j] = v = -tiny;
+         }
+      }
+      if ( fabs(v) < amin )
+         amin = fabs(v);
+      G->touched[nz++] = j;
+   }
+   if ( nz == 0 || amax > par->max_dynamism*amin )
+      return NULL;
+   rhs /= amax;
+   rhs -= EPS_RELAX*(fabs(rhs) > 1 ? fabs(rhs) : 1);
+   for ( p = 0, viol = rhs, norm = 0; p < nz; ++p ) {
+      j = G->touched[p];
+      viol -= G->pi[j]/amax * G->x[j];
+      norm += (G->pi[j]/amax) * (G->pi[j]/amax);
+   }
+   norm = sqrt(norm);
+   if ( viol < par->min_efficacy*norm )
+      return NULL;
+
+   c = (cut_t*) malloc(sizeof(cut_t));
+   c->nz = nz;
+   c->ind = (int*) malloc(nz*sizeof(int));
+   c->val = (double*) malloc(nz*sizeof(double));
+   for ( p = 0; p < nz; ++p ) {
+      c->ind[p] = G->touched[p];
+      c->val[p] = G->pi[G->touched[p]]/amax;
+   }
+   c->rhs = rhs;
+   c->norm = norm;
+   c->eff = viol/norm;
+   c->age = 0;
+   c->row = -1;
+   c->fresh = 1;
+   return c;
+}
+
+/// Violation of a cut at x over its norm
+static double efficacy(const gc_t* G, const cut_t* c) {
+   int    p;
+   double v = c->rhs;
+   for ( p = 0; p < c->nz; ++p )
+      v -= c->val[p] * G->x[c->ind[p]];
+   return v / c->norm;
+}
+
+/// Cosine between the cut c, scattered in G->dense, and the cut k
+static double parallelism(const gc_t* G, const cut_t* c, const cut_t* k) {
+   int    p;
+   double d = 0;
+   for ( p = 0; p < k->nz; ++p )
+      d += G->dense[k->ind[p]] * k->val[p];
+   return fabs(d) / (c->norm * k->norm);
+}
+
+static int by_efficacy(const void* a, const void* b) {
+   double ea = (*(cut_t* const*)a)->eff, eb = (*(cut_t* const*)b)->eff;
+   return (ea < eb) - (ea > eb);
+}
+
+/// Basis positions by decreasing fractionality
+typedef struct {
+   int    r;
+   double away;
+} frac_t;
+
+static int by_away(const void* a, const void* b) {
+   double fa = ((const frac_t*)a)->away, fb = ((const frac_t*)b)->away;
+   return (fa < fb) - (fa > fb);
+}
+
+static void print_cut(const cut_t* c) {
+   int p;
+   printf("  ");
+   for ( p = 0; p < c->nz; ++p )
+      printf(" %+.4g x%d", c->val[p], c->ind[p]+1);
+   printf(" >= %.4g   (efficacy %.4g)\n", c->rhs, c->eff);
+}
+
+/// One round of cuts at the current LP solution: returns the cuts added
+static int gc_round(gc_t* G, gc_stats_t* st, int* removed) {
+   const gc_params_t* par = G->par;
+   lp_t*    lp = G->lp;
+   int      m = lp_num_rows(lp), i, k, p, nf = 0, nc = 0, ns = 0, nd = 0;
+   frac_t*  fr = (frac_t*) malloc((m > 0 ? m : 1)*sizeof(frac_t));
+   cut_t**  cand = (cut_t**) malloc((G->npool + 4*par->max_cuts + 1)*sizeof(cut_t*));
+   cut_t**  sel = (cut_t**) malloc((par->max_cuts + 1)*sizeof(cut_t*));
+   int*     del = (int*) malloc((G->nlp + 1)*sizeof(int));
+
+   lp_get_base(lp, G->cstat, G->rstat);
+   lp_get_bhead(lp, G->head, G->xb);
+   /// Cuts in the LP: a loose cut ages, and goes back to the pool when old
+   for ( k = 0; k < G->nlp; ++k ) {
+      cut_t* c = G->lp_cut[k];
+      if ( -efficacy(G, c) * c->norm > EPS_INT*(1 + fabs(c->rhs)) ) {
+         if ( ++c->age >= par->max_age )
+            del[nd++] = G->m0 + k;
+      } else
+         c->age = 0;
+   }
+   /// Cuts of the pool: the violated ones are candidates, the others age
+   for ( i = 0, k = 0; i < G->npool; ++i ) {
+      cut_t* c = G->pool[i];
+      if ( c->row < 0 ) {
+         c->eff = efficacy(G, c);
+         if ( c->eff >= par->min_efficacy ) {
+            c->age = 0;
+            cand[nc++] = c;
+         } else if ( ++c->age > par->pool_age ) {
+            cut_free(c);
+            continue;
+         }
+      }
+      G->pool[k++] = c;
+   }
+   G->npool = k;
+   /// New cuts from the most fractional rows
+   for ( i = 0; i < m; ++i ) {
+      int    h = G->head[i];
+      double f = G->xb[i] - floor(G->xb[i]);
+      if ( (h >= 0 && !G->is_int[h]) || (h < 0 && (-1-h >= G->m0 || !G->int_row[-1-h])) )
+         continue;
+      if ( f > 0.5 )
+         f = 1 - f;
+      if ( f >= par->min_away ) {
+         fr[nf].r = i;
+         fr[nf++].away = f;
+      }
+   }
+   qsort(fr, nf, sizeof(frac_t), by_away);
+   if ( nf > 4*par->max_cuts )
+      nf = 4*par->max_cuts;
+   for ( i = 0; i < nf; ++i ) {
+      cut_t* c = gomory_cut(G, fr[i].r, G->xb[fr[i].r]);
+      if ( c != NULL ) {
+         st->generated++;
+         cand[nc++] = c;
+      }
+   }
+   /// Selection: by efficacy, skipping the cuts parallel to those selected
+   /// before (a violated cut parallel to a cut in the LP is stronger than it)
+   qsort(cand, nc, sizeof(cut_t*), by_efficacy);
+   for ( i = 0; i < nc; ++i ) {
+      cut_t* c = cand[i];
+      int    full = (ns >= par->max_cuts), ok = 1;
+      if ( !full ) {
+         for ( p = 0; p < c->nz; ++p )
+            G->dense[c->ind[p]] = c->val[p];
+         for ( k = 0; k < ns && ok; ++k )
+            if ( parallelism(G, c, sel[k]) > par->max_parallel )
+               ok = 0;
+         for ( p = 0; p < c->nz; ++p )
+            G->dense[c->ind[p]] = 0;
+         if ( ok )
+            sel[ns++] = c;
+      }
+      /// A new cut goes to the pool, unless it is parallel to another one
+      if ( c->fresh ) {
+         c->fresh = 0;
+         if ( ok ) {
+            G->pool = (cut_t**) realloc(G->pool, (G->npool+1)*sizeof(cut_t*));
+            G->pool[G->npool++] = c;
+         } else
+            cut_free(c);
+      }
+   }
+   /// Update the LP: first the old cuts go, then the new ones come
+   if ( ns > 0 && nd > 0 ) {
+      lp_del_rows(lp, nd, del);
+      for ( i = 0; i < nd; ++i ) {
+         G->lp_cut[del[i] - G->m0]->row = -1;
+         G->lp_cut[del[i] - G->m0]->age = 0;
+      }
+      for ( i = 0, k = 0; i < G->nlp; ++i )
+         if ( G->lp_cut[i]->row >= 0 ) {
+            G->lp_cut[k] = G->lp_cut[i];
+            G->lp_cut[k]->row = G->m0 + k;
+            k++;
+         }
+      G->nlp = k;
+      st->removed += nd;
+      *removed = nd;
+   }
+   if ( ns > 0 ) {
+      int     nz = 0;
+      int*    beg = (int*) malloc(ns*sizeof(int));
+      double* rhs = (double*) malloc(ns*sizeof(double));
+      char*   sense = (char*) malloc(ns*sizeof(char));
+      int*    ind;
+      double* val;
+      for ( i = 0; i < ns; ++i )
+         nz += sel[i]->nz;
+      ind = (int*) malloc(nz*sizeof(int));
+      val = (double*) malloc(nz*sizeof(double));
+      G->lp_cut = (cut_t**) realloc(G->lp_cut, (G->nlp + ns)*sizeof(cut_t*));
+      for ( i = 0, nz = 0; i < ns; ++i ) {
+         cut_t* c = sel[i];
+         beg[i] = nz;
+         rhs[i] = c->rhs;
+         sense[i] = 'G';
+         for ( p = 0; p < c->nz; ++p, ++nz ) {
+            ind[nz] = c->ind[p];
+            val[nz] = c->val[p];
+         }
+         c->row = G->m0 + G->nlp;
+         c->age = 0;
+         G->lp_cut[G->nlp++] = c;
+         if ( par->verbose > 1 )
+            print_cut(c);
+      }
+      lp_add_rows(lp, ns, nz, rhs, sense, beg, ind, val);
+      st->added += ns;
+      free(val); free(ind); free(sense); free(rhs); free(beg);
+   }
+   free(del);
+   free(sel);
+   free(cand);
+   free(fr);
+   return ns;
+}
+
+int gc_cut_loop(lp_t* lp, const char* is_int, const gc_params_t* par, gc_stats_t* st) {
+   gc_t     G;
+   int      j, status, round;
+   double   obj;
+   double*  hist = (double*) malloc((par->max_rounds + 1)*sizeof(double));
+   clock_t  start = clock();
+
+   memset(st, 0, sizeof(gc_stats_t));
+   gc_init(&G, lp, is_int, par);
+   for ( round = 0; ; ++round ) {
+      int added = 0, removed = 0;
+      if ( lp_optimize(lp) != LP_OPTIMAL ) {
+         st->status = GC_LP_FAILED;
+         break;
+      }
+      lp_solution(lp, &status, &obj, G.x, NULL, NULL, NULL);
+      gc_resize(&G, lp_num_rows(lp));
+      hist[round] = obj;
+      st->rounds = round;
+      st->bound = obj;
+      st->iterations = lp_iterations(lp);
+      if ( round == 0 )
+         st->lp_bound = obj;
+      if ( par->verbose > 0 )
+         printf("Round %3d  bound %14.6f  cuts in LP %5d  pool %5d  iter %8ld  time %.2f\n",
+                round, obj, G.nlp, G.npool, st->iterations,
+                (double)(clock() - start)/CLOCKS_PER_SEC);
+      for ( j = 0; j < G.n; ++j )
+         if ( is_int[j] && fabs(G.x[j] - floor(G.x[j] + 0.5)) > EPS_INT )
+            break;
+      if ( j == G.n ) {
+         st->status = GC_INTEGER;
+         break;
+      }
+      if ( round == par->max_rounds ) {
+         st->status = GC_ROUNDS;
+         break;
+      }
+      if ( round >= par->stall_rounds &&
+           obj - hist[round - par->stall_rounds] < par->stall_tol*(1 + fabs(obj)) ) {
+         st->status = GC_STALL;
+         break;
+      }
+      added = gc_round(&G, st, &removed);
+      if ( added == 0 ) {
+         st->status = GC_NO_CUTS;
+         break;
+      }
+      if ( par->verbose > 0 )
+         printf("           cuts added %5d  removed %5d\n", added, removed);
+   }
+   st->in_lp = G.nlp;
+   gc_free(&G);
+   free(hist);
+   return st->status;
+}
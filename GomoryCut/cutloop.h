@@ -0,0 +1,83 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Cutting plane loop with Gomory cuts, on an LP of lp.h whose columns may
+ *  be integer. Every round:
+ *   - solves the LP, starting from the basis of the previous round;
+ *   - ages the cuts in the LP: a cut whose logical is basic and not at its
+ *     bound for 'max_age' rounds goes back to the pool;
+ *   - reads the tableau row of every basic integer variable with a
+ *     fractional value, and derives a Gomory cut in the space of the
+ *     columns: the fractional cut (the mixed integer one, with 'gmi'),
+ *     where the continuous nonbasic variables (e.g. the logicals of the
+ *     cuts) take the terms of the Gomory mixed integer cut;
+ *   - makes the cuts numerically safe: the coefficients below 1/max_dynamism
+ *     of the largest one are removed by relaxing the right hand side with
+ *     the bound of their variable, or grow to that size by relaxing it with
+ *     the other bound; the cuts still with a larger ratio between the
+ *     largest and the smallest coefficient are dropped, and the right hand
+ *     side is relaxed a bit;
+ *   - selects the cuts among the new ones and those of the pool: by
+ *     decreasing efficacy (violation over the norm), skipping the cuts too
+ *     parallel to a cut selected before, up to 'max_cuts' per round.
+ *  The loop stops when the LP solution is integer, when no cut is found,
+ *  after 'max_rounds' rounds, or when the bound improves by less than
+ *  'stall_tol' (relative) in 'stall_rounds' rounds.
+ */
+
+#ifndef _CUTLOOP_H_
+#define _CUTLOOP_H_
+
+#include "lp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Why the loop stopped
+#define GC_INTEGER     0
+#define GC_NO_CUTS     1
+#define GC_STALL       2
+#define GC_ROUNDS      3
+#define GC_LP_FAILED   4
+
+typedef struct {
+   int    max_rounds;     /* rounds of cuts */
+   int    max_cuts;       /* cuts added to the LP per round */
+   double min_efficacy;   /* smallest violation over norm of a cut */
+   double max_parallel;   /* largest cosine between two cuts of a round */
+   double min_away;       /* smallest fractionality of a row for a cut */
+   double max_dynamism;   /* largest ratio between the coefficients of a cut */
+   int    max_age;        /* rounds a loose cut stays in the LP */
+   int    pool_age;       /* rounds an unviolated cut stays in the pool */
+   int    stall_rounds;   /* stall: too little improvement in these rounds */
+   double stall_tol;
+   int    gmi;            /* Gomory mixed integer cuts instead of fractional */
+   int    verbose;        /* 1: a line per round, 2: the cuts too */
+} gc_params_t;
+
+typedef struct {
+   int    status;         /* GC_INTEGER, ... */
+   int    rounds;
+   long   generated;      /* cuts derived from the tableau */
+   long   added;          /* cuts added to the LP (again, if from the pool) */
+   long   removed;        /* cuts moved from the LP to the pool */
+   int    in_lp;          /* cuts in the final LP */
+   double lp_bound;       /* bound of the LP without cuts */
+   double bound;          /* bound of the last LP */
+   long   iterations;     /* simplex iterations */
+} gc_stats_t;
+
+void gc_default_params(gc_params_t* par);
+
+/// Cutting plane loop on 'lp' (minimization): is_int[j] is nonzero if the
+/// column j is integer. The cuts are added as rows after those of 'lp',
+/// and the solution of the last round stays in 'lp'. Returns the status
+int  gc_cut_loop(lp_t* lp, const char* is_int, const gc_params_t* par, gc_stats_t* st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CUTLOOP_H_ */
@@ -0,0 +1,1208 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Bounded dual simplex with an LU factorized basis (see lp.h)
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS   /// fopen
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "lp.h"
+
+#define TOL_PRIMAL   1e-7    /* primal feasibility */
+#define TOL_DUAL     1e-7    /* dual feasibility */
+#define TOL_PIVOT    1e-9    /* smallest pivot of the ratio test */
+#define TOL_SING     1e-11   /* smallest pivot of the factorization */
+#define LU_THRESHOLD 0.1     /* pivots at least 0.1 of the largest in their column */
+#define MAX_ETA      100     /* updates before a refactorization */
+#define MAX_ITER     1000000
+#define BIG0         1e6     /* first artificial bound */
+#define BIG_MAX      1e13    /* beyond it, the LP is unbounded */
+#define SCALE_PASSES 4       /* passes of geometric scaling */
+#define SCALE_RANGE  1e6     /* the LP is scaled if its coefficients span more */
+
+/// Sparse LU of the basis: B = L U up to permutations, and the eta columns
+/// of the product form updates. Pivot k is in row prow[k] and in basis
+/// position pcol[k]; L column k has the multipliers of the rows below the
+/// pivot, and U row k the entries in the positions pivoted later
+typedef struct {
+   int      m;
+   int     *prow, *pcol;
+   int     *lbeg, *lind, lnz, lcap;
+   double  *lval;
+   int     *ubeg, *uind, unz, ucap;
+   double  *uval, *udiag;
+   int      neta;
+   int     *epos, *ebeg, *eind, enz, ecap;
+   double  *epiv, *eval;
+} lu_t;
+
+struct lp_s {
+   int      m, n;            /* rows and structural columns */
+   /// Variables: the structural columns 0..n-1, then the logicals n..n+m-1
+   double  *obj, *lb, *ub;
+   double  *rhs;
+   char    *sense;
+   /// Coefficients as triplets, and the column-wise and row-wise copies
+   /// built from them
+   int      nt, maxt;
+   int     *ti, *tj;
+   double  *tv;
+   int      dirty;
+   int     *cbeg, *cind;
+   double  *cval;
+   int     *rbeg, *rind;
+   double  *rval;
+   /// Scaled copy solved by the simplex: the variable v is scale[v] times
+   /// its scaled value, the row i is multiplied by 1/scale[n+i]
+   double  *scale, *sobj, *slb, *sub, *srhs, *sval;
+   /// Basis: head[r] is the variable of basis position r
+   int      has_basis;
+   int     *head, *stat;
+   char    *art;             /* nonbasic at an artificial bound */
+   double  *x, *d;
+   double   big;
+   lu_t     lu;
+   /// Scratch vectors of m entries, and of n+m entries
+   double  *w1, *w2, *w3, *alpha;
+   int      status;
+   long     iter;
+};
+
+static void* xrealloc(void* p, size_t size) {
+   void* q = realloc(p, size > 0 ? size : 1);
+   if ( q == NULL )
+      abort();
+   return q;
+}
+
+/// Bounds of the logical variable of a row
+static void logical_bounds(char sense, double* l, double* u) {
+   *l = (sense == 'G') ? -LP_INFINITY : 0;
+   *u = (sense == 'L') ? LP_INFINITY : 0;
+}
+
+lp_t* lp_new(void) {
+   lp_t* lp = (lp_t*) calloc(1, sizeof(lp_t));
+   lp->big = BIG0;
+   return lp;
+}
+
+static void lu_free(lu_t* F) {
+   free(F->prow); free(F->pcol);
+   free(F->lbeg); free(F->lind); free(F->lval);
+   free(F->ubeg); free(F->uind); free(F->uval); free(F->udiag);
+   free(F->epos); free(F->ebeg); free(F->eind); free(F->epiv); free(F->eval);
+   memset(F, 0, sizeof(lu_t));
+}
+
+void lp_free(lp_t* lp) {
+   if ( lp == NULL )
+      return;
+   free(lp->obj); free(lp->lb); free(lp->ub);
+   free(lp->rhs); free(lp->sense);
+   free(lp->ti); free(lp->tj); free(lp->tv);
+   free(lp->cbeg); free(lp->cind); free(lp->cval);
+   free(lp->rbeg); free(lp->rind); free(lp->rval);
+   free(lp->scale); free(lp->sobj); free(lp->slb); free(lp->sub); free(lp->srhs); free(lp->sval);
+   free(lp->head); free(lp->stat); free(lp->art);
+   free(lp->x); free(lp->d);
+   free(lp->w1); free(lp->w2); free(lp->w3); free(lp->alpha);
+   lu_free(&lp->lu);
+   free(lp);
+}
+
+int lp_num_rows(const lp_t* lp) { return lp->m; }
+int lp_num_cols(const lp_t* lp) { return lp->n; }
+long lp_iterations(const lp_t* lp) { return lp->iter; }
+
+/// Room for the variables and the rows, after a change of m or n
+static void resize(lp_t* lp) {
+   int t = lp->n + lp->m;
+   lp->obj   = (double*) xrealloc(lp->obj, t*sizeof(double));
+   lp->lb    = (double*) xrealloc(lp->lb, t*sizeof(double));
+   lp->ub    = (double*) xrealloc(lp->ub, t*sizeof(double));
+   lp->stat  = (int*) xrealloc(lp->stat, t*sizeof(int));
+   lp->art   = (char*) xrealloc(lp->art, t*sizeof(char));
+   lp->x     = (double*) xrealloc(lp->x, t*sizeof(double));
+   lp->d     = (double*) xrealloc(lp->d, t*sizeof(double));
+   lp->alpha = (double*) xrealloc(lp->alpha, t*sizeof(double));
+   lp->scale = (double*) xrealloc(lp->scale, t*sizeof(double));
+   lp->sobj  = (double*) xrealloc(lp->sobj, t*sizeof(double));
+   lp->slb   = (double*) xrealloc(lp->slb, t*sizeof(double));
+   lp->sub   = (double*) xrealloc(lp->sub, t*sizeof(double));
+   lp->srhs  = (double*) xrealloc(lp->srhs, lp->m*sizeof(double));
+   lp->rhs   = (double*) xrealloc(lp->rhs, lp->m*sizeof(double));
+   lp->sense = (char*) xrealloc(lp->sense, lp->m*sizeof(char));
+   lp->head  = (int*) xrealloc(lp->head, lp->m*sizeof(int));
+   lp->w1    = (double*) xrealloc(lp->w1, lp->m*sizeof(double));
+   lp->w2    = (double*) xrealloc(lp->w2, lp->m*sizeof(double));
+   lp->w3    = (double*) xrealloc(lp->w3, lp->m*sizeof(double));
+}
+
+int lp_new_rows(lp_t* lp, int k, const double* rhs, const char* sense) {
+   int i, v;
+   if ( k < 0 )
+      return 1;
+   lp->m += k;
+   resize(lp);
+   for ( i = lp->m-k; i < lp->m; ++i ) {
+      v = lp->n + i;
+      lp->rhs[i] = (rhs != NULL) ? rhs[i-lp->m+k] : 0;
+      lp->sense[i] = (sense != NULL) ? sense[i-lp->m+k] : 'E';
+      if ( lp->sense[i] != 'L' && lp->sense[i] != 'E' && lp->sense[i] != 'G' )
+         return 1;
+      lp->obj[v] = 0;
+      lp->scale[v] = 1;
+      logical_bounds(lp->sense[i], &lp->lb[v], &lp->ub[v]);
+      /// The logical of a new row is basic: an optimal basis stays dual feasible
+      lp->head[i] = v;
+      lp->stat[v] = LP_BASIC;
+      lp->art[v] = 0;
+      lp->x[v] = 0;
+      lp->d[v] = 0;
+   }
+   return 0;
+}
+
+int lp_new_cols(lp_t* lp, int k, const double* obj, const double* lb, const double* ub) {
+   int i, j, n0 = lp->n, t0 = lp->n + lp->m;
+   if ( k < 0 )
+      return 1;
+   lp->n += k;
+   resize(lp);
+   /// The logicals move k places up
+   for ( i = t0-1; i >= n0; --i ) {
+      lp->obj[i+k] = lp->obj[i];
+      lp->lb[i+k]  = lp->lb[i];
+      lp->ub[i+k]  = lp->ub[i];
+      lp->scale[i+k] = lp->scale[i];
+      lp->stat[i+k] = lp->stat[i];
+      lp->art[i+k] = lp->art[i];
+      lp->x[i+k]   = lp->x[i];
+      lp->d[i+k]   = lp->d[i];
+   }
+   for ( i = 0; i < lp->m; ++i )
+      if ( lp->head[i] >= n0 )
+         lp->head[i] += k;
+   for ( j = n0; j < n0+k; ++j ) {
+      lp->obj[j] = (obj != NULL) ? obj[j-n0] : 0;
+      lp->lb[j] = (lb != NULL) ? lb[j-n0] : 0;
+      lp->ub[j] = (ub != NULL) ? ub[j-n0] : LP_INFINITY;
+      lp->scale[j] = 1;
+      if ( lp->lb[j] > lp->ub[j] )
+         return 1;
+      lp->stat[j] = LP_AT_LOWER;   /// Fixed by the next solve, if needed
+      lp->art[j] = 0;
+      lp->x[j] = 0;
+      lp->d[j] = lp->obj[j];
+   }
+   lp->dirty = 1;
+   return 0;
+}
+
+int lp_chg_coef_list(lp_t* lp, int k, const int* row, const int* col, const double* val) {
+   int i;
+   if ( lp->nt + k > lp->maxt ) {
+      lp->maxt = 2*lp->maxt + k;
+      lp->ti = (int*) xrealloc(lp->ti, lp->maxt*sizeof(int));
+      lp->tj = (int*) xrealloc(lp->tj, lp->maxt*sizeof(int));
+      lp->tv = (double*) xrealloc(lp->tv, lp->maxt*sizeof(double));
+   }
+   for ( i = 0; i < k; ++i ) {
+      if ( row[i] < 0 || row[i] >= lp->m || col[i] < 0 || col[i] >= lp->n )
+         return 1;
+      lp->ti[lp->nt] = row[i];
+      lp->tj[lp->nt] = col[i];
+      lp->tv[lp->nt] = val[i];
+      lp->nt++;
+   }
+   lp->dirty = 1;
+   return 0;
+}
+
+int lp_add_rows(lp_t* lp, int k, int nz, const double* rhs, const char* sense,
+                const int* beg, const int* ind, const double* val) {
+   int i, p, m0 = lp->m, e;
+   int* row = (int*) malloc((nz > 0 ? nz : 1)*sizeof(int));
+   if ( lp_new_rows(lp, k, rhs, sense) != 0 ) {
+      free(row);
+      return 1;
+   }
+   for ( i = 0; i < k; ++i ) {
+      e = (i+1 < k) ? beg[i+1] : nz;
+      for ( p = beg[i]; p < e; ++p )
+         row[p] = m0+i;
+   }
+   e = lp_chg_coef_list(lp, nz, row, ind, val);
+   free(row);
+   return e;
+}
+
+/// Column-wise and row-wise copies of the coefficients: for repeated
+/// entries, the last one wins, and the explicit zeros are dropped
+static void build_columns(lp_t* lp) {
+   int  i, j, p, q, n = lp->n;
+   int* pos = (int*) malloc((lp->m > 0 ? lp->m : 1)*sizeof(int));
+   int* cnt = (int*) calloc(n+1, sizeof(int));
+   int* ord = (int*) malloc((lp->nt > 0 ? lp->nt : 1)*sizeof(int));
+   for ( i = 0; i < lp->nt; ++i )
+      cnt[lp->tj[i]+1]++;
+   for ( j = 0; j < n; ++j )
+      cnt[j+1] += cnt[j];
+   for ( i = 0; i < lp->nt; ++i )   /// Stable: the order of the triplets is kept
+      ord[cnt[lp->tj[i]]++] = i;
+   for ( j = n; j > 0; --j )
+      cnt[j] = cnt[j-1];
+   cnt[0] = 0;
+   lp->cbeg = (int*) xrealloc(lp->cbeg, (n+1)*sizeof(int));
+   lp->cind = (int*) xrealloc(lp->cind, lp->nt*sizeof(int));
+   lp->cval = (double*) xrealloc(lp->cval, lp->nt*sizeof(double));
+   for ( i = 0; i < lp->m; ++i )
+      pos[i] = -1;
+   q = 0;
+   for ( j = 0; j < n; ++j ) {
+      int b = q;
+      lp->cbeg[j] = q;
+      for ( p = cnt[j]; p < cnt[j+1]; ++p ) {
+         int t = ord[p];
+         if ( pos[lp->ti[t]] >= 0 )
+            lp->cval[pos[lp->ti[t]]] = lp->tv[t];
+         else {
+            pos[lp->ti[t]] = q;
+            lp->cind[q] = lp->ti[t];
+            lp->cval[q] = lp->tv[t];
+            q++;
+         }
+      }
+      /// Compact the column: drop the zeros, and reset the positions
+      for ( p = i = b; p < q; ++p ) {
+         pos[lp->cind[p]] = -1;
+         if ( lp->cval[p] != 0 ) {
+            lp->cind[i] = lp->cind[p];
+            lp->cval[i] = lp->cval[p];
+            i++;
+         }
+      }
+      q = i;
+   }
+   lp->cbeg[n] = q;
+   /// The triplets are replaced by the compacted matrix
+   for ( j = 0; j < n; ++j )
+      for ( p = lp->cbeg[j]; p < lp->cbeg[j+1]; ++p ) {
+         lp->ti[p] = lp->cind[p];
+         lp->tj[p] = j;
+         lp->tv[p] = lp->cval[p];
+      }
+   lp->nt = q;
+   /// Row-wise copy, by transposition
+   lp->rbeg = (int*) xrealloc(lp->rbeg, (lp->m+1)*sizeof(int));
+   lp->rind = (int*) xrealloc(lp->rind, q*sizeof(int));
+   lp->rval = (double*) xrealloc(lp->rval, q*sizeof(double));
+   memset(lp->rbeg, 0, (lp->m+1)*sizeof(int));
+   for ( p = 0; p < q; ++p )
+      lp->rbeg[lp->cind[p]+1]++;
+   for ( i = 0; i < lp->m; ++i )
+      lp->rbeg[i+1] += lp->rbeg[i];
+   for ( j = 0; j < n; ++j )
+      for ( p = lp->cbeg[j]; p < lp->cbeg[j+1]; ++p ) {
+         i = lp->rbeg[lp->cind[p]]++;
+         lp->rind[i] = j;
+         lp->rval[i] = lp->cval[p];
+      }
+   for ( i = lp->m; i > 0; --i )
+      lp->rbeg[i] = lp->rbeg[i-1];
+   lp->rbeg[0] = 0;
+   lp->dirty = 0;
+   free(ord);
+   free(cnt);
+   free(pos);
+}
+
+/// y . a_v for the variable v
+static double dot_column(const lp_t* lp, const double* y, int v) {
+   int    p;
+   double s = 0;
+   if ( v >= lp->n )
+      return y[v - lp->n];
+   for ( p = lp->cbeg[v]; p < lp->cbeg[v+1]; ++p )
+      s += y[lp->cind[p]] * lp->sval[p];
+   return s;
+}
+
+/// w += t a_v
+static void add_column(const lp_t* lp, double* w, int v, double t) {
+   int p;
+   if ( v >= lp->n ) {
+      w[v - lp->n] += t;
+      return;
+   }
+   for ( p = lp->cbeg[v]; p < lp->cbeg[v+1]; ++p )
+      w[lp->cind[p]] += t * lp->sval[p];
+}
+
+/// Scaled copy of the LP, by SCALE_PASSES passes of geometric scaling of
+/// the rows and of the columns: every factor is a power of 2, so that the
+/// scaling is exact. An LP whose coefficients span at most SCALE_RANGE is
+/// solved as it is, since the scaling changes the path of the simplex
+static void scale_lp(lp_t* lp) {
+   int     i, j, p, k, n = lp->n, t = lp->n + lp->m, passes = 0;
+   double* rs = lp->w1;   /// Factors of the rows
+   double* lo = lp->w2;
+   double* hi = lp->w3;
+   double  amin = LP_INFINITY, amax = 0;
+   lp->sval = (double*) xrealloc(lp->sval, lp->cbeg[n]*sizeof(double));
+   for ( j = 0; j < n; ++j )
+      lp->scale[j] = 1;
+   for ( i = 0; i < lp->m; ++i )
+      rs[i] = 1;
+   for ( p = 0; p < lp->cbeg[n]; ++p ) {
+      double a = fabs(lp->cval[p]);
+      amin = (a > 0 && a < amin) ? a : amin;
+      amax = (a > amax) ? a : amax;
+   }
+   if ( amax > SCALE_RANGE*amin )
+      passes = SCALE_PASSES;
+   for ( k = 0; k < passes; ++k ) {
+      for ( i = 0; i < lp->m; ++i ) {
+         lo[i] = LP_INFINITY;
+         hi[i] = 0;
+      }
+      for ( j = 0; j < n; ++j )
+         for ( p = lp->cbeg[j]; p < lp->cbeg[j+1]; ++p ) {
+            double a = fabs(lp->cval[p]) * lp->scale[j];
+            i = lp->cind[p];
+            lo[i] = (a < lo[i]) ? a : lo[i];
+            hi[i] = (a > hi[i]) ? a : hi[i];
+         }
+      for ( i = 0; i < lp->m; ++i )
+         if ( hi[i] > 0 )
+            rs[i] = ldexp(1.0, -(int) floor(0.5*(log2(lo[i]) + log2(hi[i])) + 0.5));
+      for ( j = 0; j < n; ++j ) {
+         double cl = LP_INFINITY, ch = 0;
+         for ( p = lp->cbeg[j]; p < lp->cbeg[j+1]; ++p ) {
+            double a = fabs(lp->cval[p]) * rs[lp->cind[p]];
+            cl = (a < cl) ? a : cl;
+            ch = (a > ch) ? a : ch;
+         }
+         if ( ch > 0 )
+            lp->scale[j] = ldexp(1.0, -(int) floor(0.5*(log2(cl) + log2(ch)) + 0.5));
+      }
+   }
+   /// A x + s = b becomes (R A C) x' + R s = R b, with x = C x' and s = R^-1 s'
+   for ( i = 0; i < lp->m; ++i ) {
+      lp->scale[n+i] = 1/rs[i];
+      lp->srhs[i] = lp->rhs[i] * rs[i];
+   }
+   for ( j = 0; j < n; ++j )
+      for ( p = lp->cbeg[j]; p < lp->cbeg[j+1]; ++p )
+         lp->sval[p] = lp->cval[p] * rs[lp->cind[p]] * lp->scale[j];
+   for ( j = 0; j < t; ++j ) {
+      lp->sobj[j] = lp->obj[j] * lp->scale[j];
+      lp->slb[j] = (lp->lb[j] > -LP_INFINITY) ? lp->lb[j] / lp->scale[j] : lp->lb[j];
+      lp->sub[j] = (lp->ub[j] < LP_INFINITY) ? lp->ub[j] / lp->scale[j] : lp->ub[j];
+   }
+}
+
+/* ---------------------------------------------------------------------- */
+/*  LU factorization                                                      */
+/* ---------------------------------------------------------------------- */
+
+static void lu_push_l(lu_t* F, int i, double v) {
+   if ( F->lnz == F->lcap ) {
+      F->lcap = 2*F->lcap + 1024;
+      F->lind = (int*) xrealloc(F->lind, F->lcap*sizeof(int));
+      F->lval = (double*) xrealloc(F->lval, F->lcap*sizeof(double));
+   }
+   F->lind[F->lnz] = i;
+   F->lval[F->lnz++] = v;
+}
+
+static void lu_push_u(lu_t* F, int j, double v) {
+   if ( F->unz == F->ucap ) {
+      F->ucap = 2*F->ucap + 1024;
+      F->uind = (int*) xrealloc(F->uind, F->ucap*sizeof(int));
+      F->uval = (double*) xrealloc(F->uval, F->ucap*sizeof(double));
+   }
+   F->uind[F->unz] = j;
+   F->uval[F->unz++] = v;
+}
+
+/// Active submatrix of the elimination: columns with values, rows with
+/// the pattern only (which may have stale entries)
+typedef struct {
+   int     *n, *cap;
+   int    **ind;
+   double **val;
+} spcols_t;
+
+static void sp_push(spcols_t* S, int j, int i, double v) {
+   if ( S->n[j] == S->cap[j] ) {
+      S->cap[j] = 2*S->cap[j] + 4;
+      S->ind[j] = (int*) xrealloc(S->ind[j], S->cap[j]*sizeof(int));
+      if ( S->val != NULL )
+         S->val[j] = (double*) xrealloc(S->val[j], S->cap[j]*sizeof(double));
+   }
+   S->ind[j][S->n[j]] = i;
+   if ( S->val != NULL )
+      S->val[j][S->n[j]] = v;
+   S->n[j]++;
+}
+
+static void sp_init(spcols_t* S, int m, int values) {
+   S->n   = (int*) calloc(m, sizeof(int));
+   S->cap = (int*) calloc(m, sizeof(int));
+   S->ind = (int**) calloc(m, sizeof(int*));
+   S->val = values ? (double**) calloc(m, sizeof(double*)) : NULL;
+}
+
+static void sp_free(spcols_t* S, int m) {
+   int j;
+   for ( j = 0; j < m; ++j ) {
+      free(S->ind[j]);
+      if ( S->val != NULL )
+         free(S->val[j]);
+   }
+   free(S->n); free(S->cap); free(S->ind); free(S->val);
+}
+
+/// Factorize the basis of 'lp': returns the number of basis positions
+/// without a pivot (singular), listed in sing[], with the rows without a
+/// pivot in free_rows[]
+static int lu_factor(lp_t* lp, int* sing, int* free_rows) {
+   lu_t*    F = &lp->lu;
+   int      m = lp->m, k, r, j, p, i, c, best, ns = 0, nf = 0;
+   spcols_t C, R;
+   char*    cdone = (char*) calloc(m, sizeof(char));
+   char*    rdone = (char*) calloc(m, sizeof(char));
+   int*     pos = (int*) malloc(m*sizeof(int));
+
+   lu_free(F);
+   F->m = m;
+   F->prow  = (int*) malloc(m*sizeof(int));
+   F->pcol  = (int*) malloc(m*sizeof(int));
+   F->lbeg  = (int*) malloc((m+1)*sizeof(int));
+   F->ubeg  = (int*) malloc((m+1)*sizeof(int));
+   F->udiag = (double*) malloc(m*sizeof(double));
+   F->ebeg  = (int*) malloc((MAX_ETA+1)*sizeof(int));
+   F->epos  = (int*) malloc(MAX_ETA*sizeof(int));
+   F->epiv  = (double*) malloc(MAX_ETA*sizeof(double));
+   F->ebeg[0] = 0;
+
+   sp_init(&C, m, 1);
+   sp_init(&R, m, 0);
+   for ( r = 0; r < m; ++r ) {
+      int v = lp->head[r];
+      if ( v >= lp->n ) {
+         sp_push(&C, r, v - lp->n, 1.0);
+         sp_push(&R, v - lp->n, r, 0);
+      } else
+         for ( p = lp->cbeg[v]; p < lp->cbeg[v+1]; ++p ) {
+            sp_push(&C, r, lp->cind[p], lp->sval[p]);
+            sp_push(&R, lp->cind[p], r, 0);
+         }
+   }
+   for ( i = 0; i < m; ++i )
+      pos[i] = -1;
+
+   for ( k = 0; k < m; ++k ) {
+      int    q = -1, piv = -1;
+      double a, amax;
+      /// Column of fewest entries, and in it the row of fewest entries
+      /// among the pivots above the threshold
+      for ( c = 0, best = lp->m+1; c < lp->m; ++c )   /// m counts the pivots left
+         if ( !cdone[c] && C.n[c] < best ) {
+            best = C.n[c];
+            q = c;
+            if ( best <= 1 )
+               break;
+         }
+      for ( p = 0, amax = 0; p < C.n[q]; ++p )
+         if ( fabs(C.val[q][p]) > amax )
+            amax = fabs(C.val[q][p]);
+      if ( amax < TOL_SING ) {   /// Singular position
+         cdone[q] = 1;
+         sing[ns++] = q;
+         F->lbeg[k] = F->lnz;
+         F->ubeg[k] = F->unz;
+         k--;
+         m--;   /// One pivot less to find
+         continue;
+      }
+      for ( p = 0, best = m+1+lp->m; p < C.n[q]; ++p )
+         if ( fabs(C.val[q][p]) >= LU_THRESHOLD*amax && R.n[C.ind[q][p]] < best ) {
+            best = R.n[C.ind[q][p]];
+            piv = p;
+         }
+      r = C.ind[q][piv];
+      a = C.val[q][piv];
+      F->prow[k] = r;
+      F->pcol[k] = q;
+      F->udiag[k] = a;
+      cdone[q] = 1;
+      rdone[r] = 1;
+      /// L column: the multipliers of the other rows of column q
+      F->lbeg[k] = F->lnz;
+      for ( p = 0; p < C.n[q]; ++p )
+         if ( p != piv ) {
+            i = C.ind[q][p];
+            lu_push_l(F, i, C.val[q][p]/a);
+            for ( j = 0; R.ind[i][j] != q; ++j )
+               ;
+            R.ind[i][j] = R.ind[i][--R.n[i]];
+         }
+      /// U row: the entries of row r in the active columns, which are
+      /// removed from their columns
+      F->ubeg[k] = F->unz;
+      for ( p = 0; p < R.n[r]; ++p ) {
+         j = R.ind[r][p];
+         if ( cdone[j] )
+            continue;
+         for ( i = 0; i < C.n[j] && C.ind[j][i] != r; ++i )
+            ;
+         if ( i == C.n[j] )
+            continue;
+         lu_push_u(F, j, C.val[j][i]);
+         C.n[j]--;
+         C.ind[j][i] = C.ind[j][C.n[j]];
+         C.val[j][i] = C.val[j][C.n[j]];
+      }
+      /// Elimination: column j -= u_j * (L column)
+      for ( p = F->ubeg[k]; p < F->unz; ++p ) {
+         int    e;
+         double u = F->uval[p];
+         j = F->uind[p];
+         for ( i = 0; i < C.n[j]; ++i )
+            pos[C.ind[j][i]] = i;
+         for ( e = F->lbeg[k]; e < F->lnz; ++e ) {
+            i = F->lind[e];
+            if ( pos[i] >= 0 )
+               C.val[j][pos[i]] -= F->lval[e]*u;
+            else {   /// Fill in
+               sp_push(&C, j, i, -F->lval[e]*u);
+               sp_push(&R, i, j, 0);
+               pos[i] = C.n[j]-1;
+            }
+         }
+         for ( i = 0; i < C.n[j]; ++i )
+            pos[C.ind[j][i]] = -1;
+      }
+   }
+   F->lbeg[m] = F->lnz;
+   F->ubeg[m] = F->unz;
+   F->m = m;   /// Pivots found
+   for ( r = 0; r < lp->m; ++r )
+      if ( !rdone[r] )
+         free_rows[nf++] = r;
+
+   sp_free(&C, lp->m);
+   sp_free(&R, lp->m);
+   free(pos);
+   free(rdone);
+   free(cdone);
+   return ns;
+}
+
+/// Solve B z = w in place: w is indexed by rows, z by basis positions
+static void ftran(lp_t* lp, double* w) {
+   lu_t*   F = &lp->lu;
+   double* z = lp->w3;
+   int     k, p, e;
+   double  t;
+   for ( k = 0; k < F->m; ++k )
+      if ( (t = w[F->prow[k]]) != 0 )
+         for ( p = F->lbeg[k]; p < F->lbeg[k+1]; ++p )
+            w[F->lind[p]] -= F->lval[p]*t;
+   for ( k = F->m-1; k >= 0; --k ) {
+      t = w[F->prow[k]];
+      for ( p = F->ubeg[k]; p < F->ubeg[k+1]; ++p )
+         t -= F->uval[p] * z[F->uind[p]];
+      z[F->pcol[k]] = t / F->udiag[k];
+   }
+   for ( e = 0; e < F->neta; ++e ) {
+      int r = F->epos[e];
+      if ( (t = z[r]) == 0 )
+         continue;
+      t /= F->epiv[e];
+      z[r] = t;
+      for ( p = F->ebeg[e]; p < F->ebeg[e+1]; ++p )
+         z[F->eind[p]] -= F->eval[p]*t;
+   }
+   memcpy(w, z, lp->m*sizeof(double));
+}
+
+/// Solve B^T y = c in place: c is indexed by basis positions, y by rows
+static void btran(lp_t* lp, double* c) {
+   lu_t*   F = &lp->lu;
+   double* y = lp->w3;
+   int     k, p, e;
+   double  t;
+   for ( e = F->neta-1; e >= 0; --e ) {
+      int r = F->epos[e];
+      t = c[r];
+      for ( p = F->ebeg[e]; p < F->ebeg[e+1]; ++p )
+         t -= F->eval[p] * c[F->eind[p]];
+      c[r] = t / F->epiv[e];
+   }
+   for ( k = 0; k < F->m; ++k ) {
+      t = c[F->pcol[k]] / F->udiag[k];
+      y[F->prow[k]] = t;
+      if ( t != 0 )
+         for ( p = F->ubeg[k]; p < F->ubeg[k+1]; ++p )
+            c[F->uind[p]] -= F->uval[p]*t;
+   }
+   for ( k = F->m-1; k >= 0; --k ) {
+      t = y[F->prow[k]];
+      for ( p = F->lbeg[k]; p < F->lbeg[k+1]; ++p )
+         t -= F->lval[p] * y[F->lind[p]];
+      y[F->prow[k]] = t;
+   }
+   memcpy(c, y, lp->m*sizeof(double));
+}
+
+/// Product form update: the basis position r gets the column whose
+/// FTRAN is 'a'
+static void lu_update(lp_t* lp, int r, const double* a) {
+   lu_t* F = &lp->lu;
+   int   i, e = F->neta;
+   F->epos[e] = r;
+   F->epiv[e] = a[r];
+   for ( i = 0; i < lp->m; ++i )
+      if ( i != r && fabs(a[i]) > 1e-14 ) {
+         if ( F->enz == F->ecap ) {
+            F->ecap = 2*F->ecap + 1024;
+            F->eind = (int*) xrealloc(F->eind, F->ecap*sizeof(int));
+            F->eval = (double*) xrealloc(F->eval, F->ecap*sizeof(double));
+         }
+         F->eind[F->enz] = i;
+         F->eval[F->enz++] = a[i];
+      }
+   F->ebeg[++F->neta] = F->enz;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Dual simplex                                                          */
+/* ---------------------------------------------------------------------- */
+
+/// Value of a nonbasic variable, from its status
+static double nonbasic_value(const lp_t* lp, int v) {
+   if ( lp->art[v] )
+      return lp->x[v];
+   switch ( lp->stat[v] ) {
+   case LP_AT_LOWER:  return lp->slb[v];
+   case LP_AT_UPPER:  return lp->sub[v];
+   default:           return 0;
+   }
+}
+
+/// Factorize the basis, replacing the singular positions with logicals
+static void refactor(lp_t* lp) {
+   int* sing = (int*) malloc(lp->m*sizeof(int));
+   int* rows = (int*) malloc(lp->m*sizeof(int));
+   int  ns, i;
+   while ( (ns = lu_factor(lp, sing, rows)) > 0 )
+      for ( i = 0; i < ns; ++i ) {
+         int v = lp->head[sing[i]], u = lp->n + rows[i];
+         lp->stat[v] = (lp->slb[v] > -LP_INFINITY) ? LP_AT_LOWER :
+                       (lp->sub[v] < LP_INFINITY) ? LP_AT_UPPER : LP_FREE_SUPER;
+         lp->x[v] = nonbasic_value(lp, v);
+         lp->head[sing[i]] = u;
+         lp->stat[u] = LP_BASIC;
+         lp->art[u] = 0;
+      }
+   free(rows);
+   free(sing);
+}
+
+/// x_B = B^-1 (b - N x_N)
+static void compute_primal(lp_t* lp) {
+   int     v, r, t = lp->n + lp->m;
+   double* w = lp->w1;
+   memcpy(w, lp->srhs, lp->m*sizeof(double));
+   for ( v = 0; v < t; ++v )
+      if ( lp->stat[v] != LP_BASIC ) {
+         lp->x[v] = nonbasic_value(lp, v);
+         if ( lp->x[v] != 0 )
+            add_column(lp, w, v, -lp->x[v]);
+      }
+   ftran(lp, w);
+   for ( r = 0; r < lp->m; ++r )
+      lp->x[lp->head[r]] = w[r];
+}
+
+/// y = B^-T c_B, and d = c - y A
+static void compute_dual(lp_t* lp) {
+   int     v, r, t = lp->n + lp->m;
+   double* y = lp->w2;
+   for ( r = 0; r < lp->m; ++r )
+      y[r] = lp->sobj[lp->head[r]];
+   btran(lp, y);
+   for ( v = 0; v < t; ++v )
+      lp->d[v] = (lp->stat[v] == LP_BASIC) ? 0 : lp->sobj[v] - dot_column(lp, y, v);
+}
+
+/// Put every nonbasic variable at the bound where it is dual feasible, or
+/// at an artificial bound: returns 1 if some value changed
+static int make_dual_feasible(lp_t* lp) {
+   int    v, t = lp->n + lp->m, changed = 0;
+   for ( v = 0; v < t; ++v ) {
+      double d = lp->d[v], l = lp->slb[v], u = lp->sub[v], old = lp->x[v];
+      int    s = lp->stat[v];
+      if ( s == LP_BASIC )
+         continue;
+      if ( l == u ) {   /// Fixed: always dual feasible
+         lp->stat[v] = LP_AT_LOWER;
+         lp->art[v] = 0;
+      } else if ( d >= TOL_DUAL || (d > -TOL_DUAL && s != LP_AT_UPPER && s != LP_FREE_SUPER) ) {
+         if ( l > -LP_INFINITY ) {
+            lp->stat[v] = LP_AT_LOWER;
+            lp->art[v] = 0;
+         } else if ( !(lp->art[v] && s == LP_AT_LOWER) ) {
+            lp->stat[v] = LP_AT_LOWER;
+            lp->art[v] = 1;
+            lp->x[v] = (u < LP_INFINITY ? u : 0) - lp->big;
+         }
+      } else if ( d <= -TOL_DUAL || s == LP_AT_UPPER ) {
+         if ( u < LP_INFINITY ) {
+            lp->stat[v] = LP_AT_UPPER;
+            lp->art[v] = 0;
+         } else if ( !(lp->art[v] && s == LP_AT_UPPER) ) {
+            lp->stat[v] = LP_AT_UPPER;
+            lp->art[v] = 1;
+            lp->x[v] = (l > -LP_INFINITY ? l : 0) + lp->big;
+         }
+      }
+      /// else: free at zero with a null reduced cost
+      if ( nonbasic_value(lp, v) != old )
+         changed = 1;
+      lp->x[v] = nonbasic_value(lp, v);
+   }
+   return changed;
+}
+
+/// Once the LP with the artificial bounds is optimal: the variables at an
+/// artificial bound go to their real bound if their reduced cost allows
+/// it, or else the box is enlarged. Returns 0 if none is left, 1 if the
+/// search goes on, and -1 if the LP is unbounded
+static int remove_artificial(lp_t* lp) {
+   int v, t = lp->n + lp->m, left = 0, grow = 0;
+   for ( v = 0; v < t; ++v )
+      if ( lp->stat[v] != LP_BASIC && lp->art[v] ) {
+         double d = lp->d[v];
+         left = 1;
+         if ( lp->stat[v] == LP_AT_UPPER && d > -TOL_DUAL )
+            lp->stat[v] = (lp->slb[v] > -LP_INFINITY) ? LP_AT_LOWER : LP_FREE_SUPER;
+         else if ( lp->stat[v] == LP_AT_LOWER && d < TOL_DUAL )
+            lp->stat[v] = (lp->sub[v] < LP_INFINITY) ? LP_AT_UPPER : LP_FREE_SUPER;
+         else {
+            grow = 1;
+            continue;
+         }
+         lp->art[v] = 0;
+      }
+   if ( !left )
+      return 0;
+   if ( grow ) {
+      if ( lp->big >= BIG_MAX )
+         return -1;
+      lp->big *= 100;
+      for ( v = 0; v < t; ++v )
+         if ( lp->stat[v] != LP_BASIC && lp->art[v] ) {
+            double l = lp->slb[v], u = lp->sub[v];
+            lp->x[v] = (lp->stat[v] == LP_AT_UPPER) ? (l > -LP_INFINITY ? l : 0) + lp->big
+                                                     : (u < LP_INFINITY ? u : 0) - lp->big;
+         }
+   }
+   return 1;
+}
+
+/// Basic variable to leave: the largest bound violation (-1 if none)
+static int choose_row(lp_t* lp, int bland) {
+   int    r, best = -1;
+   double vmax = 0;
+   for ( r = 0; r < lp->m; ++r ) {
+      int    v = lp->head[r];
+      double x = lp->x[v], viol = 0;
+      if ( x < lp->slb[v] - (TOL_PRIMAL + 1e-9*fabs(lp->slb[v])) )
+         viol = lp->slb[v] - x;
+      else if ( x > lp->sub[v] + (TOL_PRIMAL + 1e-9*fabs(lp->sub[v])) )
+         viol = x - lp->sub[v];
+      if ( viol > vmax ) {
+         vmax = viol;
+         best = r;
+         if ( bland )
+            break;
+      }
+   }
+   return best;
+}
+
+int lp_optimize(lp_t* lp) {
+   int     m = lp->m, t, r, v, q, k, degenerate = 0;
+   double* rho = lp->w2;
+   double* alpha = lp->alpha;
+   double* col = lp->w1;
+   double  obj = -LP_INFINITY;
+
+   if ( lp->dirty )
+      build_columns(lp);
+   scale_lp(lp);
+   t = lp->n + m;
+   if ( !lp->has_basis ) {   /// Slack basis
+      for ( r = 0; r < m; ++r ) {
+         lp->head[r] = lp->n + r;
+         lp->stat[lp->n + r] = LP_BASIC;
+      }
+      for ( v = 0; v < lp->n; ++v ) {
+         lp->stat[v] = LP_AT_LOWER;
+         lp->art[v] = 0;
+      }
+      lp->has_basis = 1;
+   }
+   lp->status = LP_IT_LIM;
+   refactor(lp);
+   compute_dual(lp);
+   make_dual_feasible(lp);
+   compute_primal(lp);
+
+   for ( k = 0; k < MAX_ITER; ++k ) {
+      int    s, ps;
+      double theta_d, theta_p, delta, bound, amax, tmax, z;
+
+      if ( lp->lu.neta == MAX_ETA ) {
+         refactor(lp);
+         compute_dual(lp);
+         if ( make_dual_feasible(lp) )
+            obj = -LP_INFINITY;   /// A new start for the stalling test
+         compute_primal(lp);
+      }
+      r = choose_row(lp, degenerate > 50);
+      if ( r < 0 ) {
+         int a = remove_artificial(lp);
+         if ( a == 0 ) {
+            lp->status = LP_OPTIMAL;
+            break;
+         }
+         if ( a < 0 ) {
+            lp->status = LP_UNBOUNDED;
+            break;
+         }
+         compute_primal(lp);
+         obj = -LP_INFINITY;
+         continue;
+      }
+      /// Row r of B^-1 A
+      v = lp->head[r];
+      if ( lp->x[v] < lp->slb[v] ) {
+         s = -1;
+         bound = lp->slb[v];
+      } else {
+         s = 1;
+         bound = lp->sub[v];
+      }
+      delta = lp->x[v] - bound;
+      memset(rho, 0, m*sizeof(double));
+      rho[r] = 1;
+      btran(lp, rho);
+      /// Harris ratio test: the largest step within the tolerances, and
+      /// then the largest pivot within that step
+      tmax = LP_INFINITY;
+      for ( q = 0; q < t; ++q ) {
+         alpha[q] = 0;
+         if ( lp->stat[q] == LP_BASIC || lp->slb[q] == lp->sub[q] )
+            continue;
+         alpha[q] = dot_column(lp, rho, q);
+         z = s*alpha[q];
+         if ( (z > TOL_PIVOT && lp->stat[q] != LP_AT_UPPER) ) {
+            if ( (lp->d[q] + TOL_DUAL)/z < tmax )
+               tmax = (lp->d[q] + TOL_DUAL)/z;
+         } else if ( z < -TOL_PIVOT && lp->stat[q] != LP_AT_LOWER ) {
+            if ( (lp->d[q] - TOL_DUAL)/z < tmax )
+               tmax = (lp->d[q] - TOL_DUAL)/z;
+         }
+      }
+      if ( tmax >= LP_INFINITY ) {
+         lp->status = LP_INFEASIBLE;
+         break;
+      }
+      for ( q = 0, ps = -1, amax = 0; q < t; ++q ) {
+         z = s*alpha[q];
+         if ( lp->stat[q] == LP_BASIC || lp->slb[q] == lp->sub[q] )
+            continue;
+         if ( (z > TOL_PIVOT && lp->stat[q] != LP_AT_UPPER) || (z < -TOL_PIVOT && lp->stat[q] != LP_AT_LOWER) )
+            if ( lp->d[q]/z <= tmax && fabs(z) > amax ) {
+               amax = fabs(z);
+               ps = q;
+               if ( degenerate > 50 )   /// Smallest index, against cycling
+                  break;
+            }
+      }
+      q = ps;
+      /// Entering column
+      memset(col, 0, m*sizeof(double));
+      add_column(lp, col, q, 1.0);
+      ftran(lp, col);
+      if ( fabs(col[r] - alpha[q]) > 1e-6*(1 + fabs(col[r])) && lp->lu.neta > 0 ) {
+         /// Numerical trouble: refactorize and try again
+         refactor(lp);
+         compute_dual(lp);
+         if ( make_dual_feasible(lp) )
+            obj = -LP_INFINITY;
+         compute_primal(lp);
+         continue;
+      }
+      /// Dual step
+      theta_d = lp->d[q] / alpha[q];
+      for ( ps = 0; ps < t; ++ps )
+         if ( lp->stat[ps] != LP_BASIC && alpha[ps] != 0 )
+            lp->d[ps] -= theta_d * alpha[ps];
+      lp->d[q] = 0;
+      lp->d[v] = -theta_d;
+      /// Primal step
+      theta_p = delta / col[r];
+      for ( ps = 0; ps < m; ++ps )
+         if ( col[ps] != 0 )
+            lp->x[lp->head[ps]] -= theta_p * col[ps];
+      lp->x[q] += theta_p;
+      lp->x[v] = bound;
+      /// Basis change
+      lp->stat[v] = (s < 0) ? LP_AT_LOWER : LP_AT_UPPER;
+      lp->art[v] = 0;
+      lp->stat[q] = LP_BASIC;
+      lp->art[q] = 0;
+      lp->head[r] = q;
+      lu_update(lp, r, col);
+      lp->iter++;
+      /// Stalling of the dual objective
+      for ( z = 0, ps = 0; ps < t; ++ps )
+         z += lp->sobj[ps] * lp->x[ps];
+      degenerate = (z > obj + 1e-9*(1 + fabs(obj))) ? 0 : degenerate+1;
+      if ( z > obj )
+         obj = z;
+   }
+   /// Clean values at the end
+   if ( lp->status == LP_OPTIMAL ) {
+      refactor(lp);
+      compute_dual(lp);
+      compute_primal(lp);
+   }
+   return lp->status;
+}
+
+int lp_solution(const lp_t* lp, int* status, double* obj, double* x, double* pi,
+                double* slack, double* dj) {
+   int    i, j;
+   double z = 0;
+   for ( j = 0; j < lp->n; ++j )
+      z += lp->sobj[j] * lp->x[j];
+   if ( status != NULL )
+      *status = lp->status;
+   if ( obj != NULL )
+      *obj = z;
+   /// Back from the scaled values
+   if ( x != NULL )
+      for ( j = 0; j < lp->n; ++j )
+         x[j] = lp->x[j] * lp->scale[j];
+   if ( dj != NULL )
+      for ( j = 0; j < lp->n; ++j )
+         dj[j] = lp->d[j] / lp->scale[j];
+   if ( slack != NULL )
+      for ( i = 0; i < lp->m; ++i )
+         slack[i] = lp->x[lp->n + i] * lp->scale[lp->n + i];
+   if ( pi != NULL )   /// The reduced cost of a logical is -pi
+      for ( i = 0; i < lp->m; ++i )
+         pi[i] = -lp->d[lp->n + i] / lp->scale[lp->n + i];
+   return (lp->status == LP_OPTIMAL) ? 0 : 1;
+}
+
+int lp_del_rows(lp_t* lp, int k, const int* rows) {
+   int   i, p, q, r, v, t = lp->n + lp->m, keep_basis = lp->has_basis;
+   int*  map = (int*) malloc((t > 0 ? t : 1)*sizeof(int));
+   char* del = (char*) calloc(lp->m > 0 ? lp->m : 1, sizeof(char));
+   for ( i = 0; i < k; ++i ) {
+      if ( rows[i] < 0 || rows[i] >= lp->m ) {
+         free(del);
+         free(map);
+         return 1;
+      }
+      del[rows[i]] = 1;
+   }
+   /// New index of every variable and of every row (-1 if deleted)
+   for ( v = 0; v < lp->n; ++v )
+      map[v] = v;
+   for ( i = 0, r = 0; i < lp->m; ++i ) {
+      map[lp->n + i] = del[i] ? -1 : lp->n + r++;
+      if ( del[i] && lp->stat[lp->n + i] != LP_BASIC )
+         keep_basis = 0;
+   }
+   for ( v = 0; v < t; ++v )
+      if ( map[v] >= 0 ) {
+         q = map[v];
+         lp->obj[q] = lp->obj[v];
+         lp->lb[q] = lp->lb[v];
+         lp->ub[q] = lp->ub[v];
+         lp->scale[q] = lp->scale[v];
+         lp->stat[q] = lp->stat[v];
+         lp->art[q] = lp->art[v];
+         lp->x[q] = lp->x[v];
+         lp->d[q] = lp->d[v];
+      }
+   /// The basis positions of the deleted logicals go away
+   for ( p = 0, q = 0; p < lp->m; ++p )
+      if ( map[lp->head[p]] >= 0 )
+         lp->head[q++] = map[lp->head[p]];
+   for ( i = 0; i < lp->m; ++i )
+      if ( !del[i] ) {
+         q = map[lp->n + i] - lp->n;
+         lp->rhs[q] = lp->rhs[i];
+         lp->sense[q] = lp->sense[i];
+      }
+   for ( p = 0, q = 0; p < lp->nt; ++p )
+      if ( !del[lp->ti[p]] ) {
+         lp->ti[q] = map[lp->n + lp->ti[p]] - lp->n;
+         lp->tj[q] = lp->tj[p];
+         lp->tv[q++] = lp->tv[p];
+      }
+   lp->nt = q;
+   lp->m = r;
+   lp->dirty = 1;
+   /// If a deleted logical was nonbasic, the basis has too many variables:
+   /// the next solve starts from the slack basis
+   lp->has_basis = keep_basis;
+   free(del);
+   free(map);
+   return 0;
+}
+
+int lp_get_bounds(const lp_t* lp, double* lb, double* ub) {
+   if ( lb != NULL )
+      memcpy(lb, lp->lb, lp->n*sizeof(double));
+   if ( ub != NULL )
+      memcpy(ub, lp->ub, lp->n*sizeof(double));
+   return 0;
+}
+
+int lp_get_rhs(const lp_t* lp, double* rhs, char* sense) {
+   if ( rhs != NULL )
+      memcpy(rhs, lp->rhs, lp->m*sizeof(double));
+   if ( sense != NULL )
+      memcpy(sense, lp->sense, lp->m*sizeof(char));
+   return 0;
+}
+
+int lp_get_row(lp_t* lp, int i, int* ind, double* val) {
+   int p, q = 0;
+   if ( lp->dirty )
+      build_columns(lp);
+   for ( p = lp->rbeg[i]; p < lp->rbeg[i+1]; ++p, ++q ) {
+      ind[q] = lp->rind[p];
+      val[q] = lp->rval[p];
+   }
+   return q;
+}
+
+int lp_get_bhead(const lp_t* lp, int* head, double* x) {
+   int r;
+   if ( !lp->has_basis )
+      return 1;
+   for ( r = 0; r < lp->m; ++r ) {
+      int v = lp->head[r];
+      if ( head != NULL )
+         head[r] = (v < lp->n) ? v : -1 - (v - lp->n);
+      if ( x != NULL )
+         x[r] = lp->x[v] * lp->scale[v];
+   }
+   return 0;
+}
+
+int lp_get_base(const lp_t* lp, int* cstat, int* rstat) {
+   int i;
+   if ( !lp->has_basis )
+      return 1;
+   if ( cstat != NULL )
+      for ( i = 0; i < lp->n; ++i )
+         cstat[i] = lp->stat[i];
+   if ( rstat != NULL )
+      for ( i = 0; i < lp->m; ++i )
+         rstat[i] = lp->stat[lp->n + i];
+   return 0;
+}
+
+/// Row i of the inverse of the scaled basis
+static int binv_row(lp_t* lp, int i, double* z) {
+   if ( !lp->has_basis || i < 0 || i >= lp->m )
+      return 1;
+   memset(z, 0, lp->m*sizeof(double));
+   z[i] = 1;
+   btran(lp, z);
+   return 0;
+}
+
+/// The entry of the scaled tableau in the row of the basic variable u and
+/// in the column of the variable v is multiplied by scale[u]/scale[v]
+int lp_binvrow(lp_t* lp, int i, double* z) {
+   int k;
+   if ( binv_row(lp, i, z) != 0 )
+      return 1;
+   for ( k = 0; k < lp->m; ++k )
+      z[k] *= lp->scale[lp->head[i]] / lp->scale[lp->n + k];
+   return 0;
+}
+
+int lp_binvarow(lp_t* lp, int i, double* z) {
+   int j;
+   if ( binv_row(lp, i, lp->w2) != 0 )
+      return 1;
+   for ( j = 0; j < lp->n; ++j )
+      z[j] = dot_column(lp, lp->w2, j) * lp->scale[lp->head[i]] / lp->scale[j];
+   return 0;
+}
+
+int lp_write(lp_t* lp, const char* filename) {
+   int   i, j, p, first;
+   FILE* out = fopen(filename, "w");
+   if ( out == NULL )
+      return 1;
+   if ( lp->dirty )
+      build_columns(lp);
+   fprintf(out, "Minimize\n obj:");
+   for ( j = 0; j < lp->n; ++j )
+      if ( lp->obj[j] != 0 )
+         fprintf(out, " %+.12g x%d", lp->obj[j], j+1);
+   fprintf(out, "\nSubject To\n");
+   for ( i = 0; i < lp->m; ++i ) {
+      fprintf(out, " c%d:", i+1);
+      for ( p = lp->rbeg[i], first = 1; p < lp->rbeg[i+1]; ++p ) {
+         fprintf(out, " %+.12g x%d", lp->rval[p], lp->rind[p]+1);
+         first = 0;
+      }
+      if ( first )
+         fprintf(out, " 0 x1");
+      fprintf(out, " %s %.12g\n", lp->sense[i] == 'L' ? "<=" : lp->sense[i] == 'G' ? ">=" : "=",
+              lp->rhs[i]);
+   }
+   fprintf(out, "Bounds\n");
+   for ( j = 0; j < lp->n; ++j ) {
+      double l = lp->lb[j], u = lp->ub[j];
+      if ( l <= -LP_INFINITY && u >= LP_INFINITY )
+         fprintf(out, " x%d free\n", j+1);
+      else if ( l == u )
+         fprintf(out, " x%d = %.12g\n", j+1, l);
+      else {
+         if ( l != 0 )
+            fprintf(out, " x%d >= %.12g\n", j+1, l);
+         if ( u < LP_INFINITY )
+            fprintf(out, " x%d <= %.12g\n", j+1, u);
+      }
+   }
+   fprintf(out, "End\n");
+   fclose(out);
+   return 0;
+}
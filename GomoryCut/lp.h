@@ -0,0 +1,117 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Self-contained LP solver for the Gomory cut examples, in place of the
+ *  CPLEX callable library:
+ *
+ *     min { cx | Ax (<=, =, >=) b, l <= x <= u }
+ *
+ *  Every row i has a logical variable s_i, with Ax + s = b, whose bounds
+ *  encode the sense of the row. The LP is solved by a bounded dual simplex:
+ *   - on a scaled copy of the LP (geometric scaling of the rows and of the
+ *     columns, by powers of 2): the solution, the basis and the rows of the
+ *     tableau returned by the API are those of the LP as given;
+ *   - the basis is factorized as B = LU by sparse Gaussian elimination
+ *     (Markowitz pivoting with a threshold on the pivots), and the basis
+ *     changes are product form updates (eta columns) on top of the LU,
+ *     until the next refactorization;
+ *   - the basis of the last solve is kept: the rows added to an optimal
+ *     LP (e.g. cuts) have a basic logical, so the basis stays dual feasible
+ *     and the next solve is warm started;
+ *   - a nonbasic variable that is dual infeasible at its bound, or that
+ *     has no finite bound on the right side, is put at an artificial bound
+ *     (a big box), which is removed once the LP is optimal.
+ *  The API mirrors the CPLEX calls used by cpx_gomory.c: all the functions
+ *  returning int give 0 on success.
+ */
+
+#ifndef _LP_H_
+#define _LP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Basis status of a variable (as CPX_AT_LOWER, ...)
+#define LP_AT_LOWER     0
+#define LP_BASIC        1
+#define LP_AT_UPPER     2
+#define LP_FREE_SUPER   3
+
+/// Solution status (as CPX_STAT_OPTIMAL, ...)
+#define LP_OPTIMAL      1
+#define LP_UNBOUNDED    2
+#define LP_INFEASIBLE   3
+#define LP_IT_LIM       10
+
+/// Infinite bound (as CPX_INFBOUND)
+#define LP_INFINITY     1e20
+
+typedef struct lp_s lp_t;
+
+lp_t* lp_new(void);
+void  lp_free(lp_t* lp);
+
+int   lp_num_rows(const lp_t* lp);
+int   lp_num_cols(const lp_t* lp);
+
+/// 'k' new rows without coefficients, with sense 'L', 'E' or 'G'
+int   lp_new_rows(lp_t* lp, int k, const double* rhs, const char* sense);
+
+/// 'k' new columns without coefficients: 'lb' and 'ub' may be NULL, for
+/// the bounds 0 and LP_INFINITY
+int   lp_new_cols(lp_t* lp, int k, const double* obj, const double* lb, const double* ub);
+
+/// A[row[i]][col[i]] = val[i], for i in 0..k-1
+int   lp_chg_coef_list(lp_t* lp, int k, const int* row, const int* col, const double* val);
+
+/// 'k' new rows with 'nz' coefficients: row i has the coefficients
+/// val[beg[i]..beg[i+1]) in the columns ind[beg[i]..beg[i+1]), with beg[k] = nz
+int   lp_add_rows(lp_t* lp, int k, int nz, const double* rhs, const char* sense,
+                  const int* beg, const int* ind, const double* val);
+
+/// Delete the 'k' rows listed in 'rows': the rows after them move down.
+/// The basis is kept if the logicals of the deleted rows are all basic
+int   lp_del_rows(lp_t* lp, int k, const int* rows);
+
+/// Bounds of the columns, right hand sides and senses of the rows: any of
+/// the arrays may be NULL
+int   lp_get_bounds(const lp_t* lp, double* lb, double* ub);
+int   lp_get_rhs(const lp_t* lp, double* rhs, char* sense);
+
+/// Coefficients of row i, in ind[] and val[]: returns their number
+int   lp_get_row(lp_t* lp, int i, int* ind, double* val);
+
+/// Solve the LP from the current basis: returns the solution status
+int   lp_optimize(lp_t* lp);
+
+/// Solution of the last solve: any of the arrays may be NULL. 'x' and 'dj'
+/// have one entry per column, 'pi' and 'slack' one per row
+int   lp_solution(const lp_t* lp, int* status, double* obj, double* x, double* pi,
+                  double* slack, double* dj);
+
+/// Basis status of the columns and of the rows: either may be NULL
+int   lp_get_base(const lp_t* lp, int* cstat, int* rstat);
+
+/// Basic variable of every basis position, as CPXgetbhead: head[r] = j
+/// for the column j, and head[r] = -1-i for the logical of row i; 'x' has
+/// their values. Either may be NULL
+int   lp_get_bhead(const lp_t* lp, int* head, double* x);
+
+/// Row i of B^-1 (one entry per row), and row i of B^-1 A (one entry per
+/// column), where the basic variable of row i is the i-th of the basis
+int   lp_binvrow(lp_t* lp, int i, double* z);
+int   lp_binvarow(lp_t* lp, int i, double* z);
+
+/// Write the LP in the CPLEX LP format (logicals are implicit)
+int   lp_write(lp_t* lp, const char* filename);
+
+/// Simplex iterations of all the solves
+long  lp_iterations(const lp_t* lp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LP_H_ */
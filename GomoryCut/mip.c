@@ -0,0 +1,571 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Sparse storage of an integer program, and its readers (see mip.h)
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS   /// fopen, fscanf and strcpy
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "mip.h"
+
+static void* xrealloc(void* p, size_t size) {
+   void* q = realloc(p, size > 0 ? size : 1);
+   if ( q == NULL )
+      abort();
+   return q;
+}
+
+static char* xstrdup(const char* s) {
+   char* t;
+   if ( s == NULL )
+      return NULL;
+   t = (char*) xrealloc(NULL, strlen(s)+1);
+   strcpy(t, s);
+   return t;
+}
+
+mip_t* mip_new(const char* name) {
+   mip_t* P = (mip_t*) calloc(1, sizeof(mip_t));
+   P->name = xstrdup(name != NULL ? name : "");
+   return P;
+}
+
+void mip_free(mip_t* P) {
+   int i;
+   if ( P == NULL )
+      return;
+   for ( i = 0; i < P->n; ++i )
+      free(P->cname[i]);
+   for ( i = 0; i < P->m; ++i )
+      free(P->rname[i]);
+   free(P->name);
+   free(P->obj); free(P->lb); free(P->ub); free(P->is_int); free(P->cname);
+   free(P->rhs); free(P->sense); free(P->rname);
+   free(P->rbeg); free(P->rind); free(P->rval);
+   free(P->cbeg); free(P->cind); free(P->cval);
+   free(P->ti); free(P->tj); free(P->tv);
+   free(P);
+}
+
+int mip_add_col(mip_t* P, double obj, double lb, double ub, int is_int, const char* name) {
+   if ( P->n == P->ncap ) {
+      P->ncap = 2*P->ncap + 16;
+      P->obj    = (double*) xrealloc(P->obj, P->ncap*sizeof(double));
+      P->lb     = (double*) xrealloc(P->lb, P->ncap*sizeof(double));
+      P->ub     = (double*) xrealloc(P->ub, P->ncap*sizeof(double));
+      P->is_int = (char*) xrealloc(P->is_int, P->ncap*sizeof(char));
+      P->cname  = (char**) xrealloc(P->cname, P->ncap*sizeof(char*));
+   }
+   P->obj[P->n] = obj;
+   P->lb[P->n] = lb;
+   P->ub[P->n] = ub;
+   P->is_int[P->n] = (char) (is_int != 0);
+   P->cname[P->n] = xstrdup(name);
+   return P->n++;
+}
+
+int mip_add_row(mip_t* P, char sense, double rhs, const char* name) {
+   if ( P->m == P->mcap ) {
+      P->mcap = 2*P->mcap + 16;
+      P->rhs   = (double*) xrealloc(P->rhs, P->mcap*sizeof(double));
+      P->sense = (char*) xrealloc(P->sense, P->mcap*sizeof(char));
+      P->rname = (char**) xrealloc(P->rname, P->mcap*sizeof(char*));
+   }
+   P->rhs[P->m] = rhs;
+   P->sense[P->m] = sense;
+   P->rname[P->m] = xstrdup(name);
+   return P->m++;
+}
+
+void mip_add_coef(mip_t* P, int i, int j, double v) {
+   if ( P->nt == P->tcap ) {
+      P->tcap = 2*P->tcap + 1024;
+      P->ti = (int*) xrealloc(P->ti, P->tcap*sizeof(int));
+      P->tj = (int*) xrealloc(P->tj, P->tcap*sizeof(int));
+      P->tv = (double*) xrealloc(P->tv, P->tcap*sizeof(double));
+   }
+   P->ti[P->nt] = i;
+   P->tj[P->nt] = j;
+   P->tv[P->nt++] = v;
+}
+
+void mip_build(mip_t* P) {
+   int  i, j, p, q, nz;
+   int* pos = (int*) malloc((P->n > 0 ? P->n : 1)*sizeof(int));
+
+   /// Rows, by a counting sort of the triplets
+   P->rbeg = (int*) xrealloc(P->rbeg, (P->m+1)*sizeof(int));
+   P->rind = (int*) xrealloc(P->rind, P->nt*sizeof(int));
+   P->rval = (double*) xrealloc(P->rval, P->nt*sizeof(double));
+   memset(P->rbeg, 0, (P->m+1)*sizeof(int));
+   for ( p = 0; p < P->nt; ++p )
+      P->rbeg[P->ti[p]+1]++;
+   for ( i = 0; i < P->m; ++i )
+      P->rbeg[i+1] += P->rbeg[i];
+   for ( p = 0; p < P->nt; ++p ) {
+      q = P->rbeg[P->ti[p]]++;
+      P->rind[q] = P->tj[p];
+      P->rval[q] = P->tv[p];
+   }
+   for ( i = P->m; i > 0; --i )
+      P->rbeg[i] = P->rbeg[i-1];
+   P->rbeg[0] = 0;
+   /// Sum the repeated entries of every row, and drop the zeros
+   for ( j = 0; j < P->n; ++j )
+      pos[j] = -1;
+   for ( i = 0, nz = 0; i < P->m; ++i ) {
+      int b = nz;
+      for ( p = P->rbeg[i]; p < P->rbeg[i+1]; ++p ) {
+         j = P->rind[p];
+         if ( pos[j] >= 0 )
+            P->rval[pos[j]] += P->rval[p];
+         else {
+            pos[j] = nz;
+            P->rind[nz] = j;
+            P->rval[nz++] = P->rval[p];
+         }
+      }
+      P->rbeg[i] = b;
+      for ( p = q = b; p < nz; ++p ) {
+         pos[P->rind[p]] = -1;
+         if ( P->rval[p] != 0 ) {
+            P->rind[q] = P->rind[p];
+            P->rval[q++] = P->rval[p];
+         }
+      }
+      nz = q;
+   }
+   P->rbeg[P->m] = nz;
+   P->nz = nz;
+   /// Columns, by transposition
+   P->cbeg = (int*) xrealloc(P->cbeg, (P->n+1)*sizeof(int));
+   P->cind = (int*) xrealloc(P->cind, nz*sizeof(int));
+   P->cval = (double*) xrealloc(P->cval, nz*sizeof(double));
+   memset(P->cbeg, 0, (P->n+1)*sizeof(int));
+   for ( p = 0; p < nz; ++p )
+      P->cbeg[P->rind[p]+1]++;
+   for ( j = 0; j < P->n; ++j )
+      P->cbeg[j+1] += P->cbeg[j];
+   for ( i = 0; i < P->m; ++i )
+      for ( p = P->rbeg[i]; p < P->rbeg[i+1]; ++p ) {
+         q = P->cbeg[P->rind[p]]++;
+         P->cind[q] = i;
+         P->cval[q] = P->rval[p];
+      }
+   for ( j = P->n; j > 0; --j )
+      P->cbeg[j] = P->cbeg[j-1];
+   P->cbeg[0] = 0;
+   /// The triplets are replaced by the built matrix
+   for ( i = 0; i < P->m; ++i )
+      for ( p = P->rbeg[i]; p < P->rbeg[i+1]; ++p ) {
+         P->ti[p] = i;
+         P->tj[p] = P->rind[p];
+         P->tv[p] = P->rval[p];
+      }
+   P->nt = nz;
+   free(pos);
+}
+
+mip_t* mip_read_mat(const char* filename) {
+   int    i, j, n = 0, m = 0;
+   double v;
+   FILE*  in = fopen(filename, "r");
+   mip_t* P;
+
+   if ( in == NULL ) {
+      fprintf(stderr, "Impossible to open file: %s\n", filename);
+      return NULL;
+   }
+   /// The number of variables, and of rows with the cost vector
+   if ( fscanf(in, "%d %d", &n, &m) != 2 || n < 0 || m < 1 ) {
+      fprintf(stderr, "%s: bad header\n", filename);
+      fclose(in);
+      return NULL;
+   }
+   P = mip_new(filename);
+   for ( j = 0; j < n; ++j ) {
+      if ( fscanf(in, "%lf", &v) != 1 )
+         goto ERROR;
+      mip_add_col(P, v, 0, MIP_INFINITY, 1, NULL);
+   }
+   if ( fscanf(in, "%lf", &v) != 1 )   /// The rhs of the cost vector
+      goto ERROR;
+   for ( i = 0; i < m-1; ++i ) {
+      mip_add_row(P, 'L', 0, NULL);
+      for ( j = 0; j < n; ++j ) {
+         if ( fscanf(in, "%lf", &v) != 1 )
+            goto ERROR;
+         if ( v != 0 )
+            mip_add_coef(P, i, j, v);
+      }
+      if ( fscanf(in, "%lf", &P->rhs[i]) != 1 )
+         goto ERROR;
+   }
+   fclose(in);
+   mip_build(P);
+   return P;
+
+ERROR:
+   fprintf(stderr, "%s: the file ends too early\n", filename);
+   fclose(in);
+   mip_free(P);
+   return NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  MPS reader                                                            */
+/* ---------------------------------------------------------------------- */
+
+/// Map from the names to the indices, by open addressing
+typedef struct {
+   int    cap, n;
+   char** key;
+   int*   val;
+} names_t;
+
+static unsigned hash_name(const char* s) {
+   unsigned h = 2166136261u;   /// FNV-1a
+   while ( *s )
+      h = (h ^ (unsigned char) *s++) * 16777619u;
+   return h;
+}
+
+static void names_free(names_t* H) {
+   int i;
+   for ( i = 0; i < H->cap; ++i )
+      free(H->key[i]);
+   free(H->key);
+   free(H->val);
+}
+
+/// Index of 'name', or -1
+static int names_get(const names_t* H, const char* name) {
+   unsigned i;
+   if ( H->cap == 0 )
+      return -1;
+   for ( i = hash_name(name) & (H->cap-1); H->key[i] != NULL; i = (i+1) & (H->cap-1) )
+      if ( strcmp(H->key[i], name) == 0 )
+         return H->val[i];
+   return -1;
+}
+
+static void names_put(names_t* H, const char* name, int v) {
+   unsigned i;
+   if ( 2*(H->n+1) > H->cap ) {   /// Load at most 1/2
+      names_t G = { 0, 0, NULL, NULL };
+      G.cap = (H->cap > 0) ? 2*H->cap : 1024;
+      G.key = (char**) calloc(G.cap, sizeof(char*));
+      G.val = (int*) malloc(G.cap*sizeof(int));
+      for ( i = 0; i < (unsigned) H->cap; ++i )
+         if ( H->key[i] != NULL ) {
+            unsigned k = hash_name(H->key[i]) & (G.cap-1);
+            while ( G.key[k] != NULL )
+               k = (k+1) & (G.cap-1);
+            G.key[k] = H->key[i];
+            G.val[k] = H->val[i];
+         }
+      free(H->key);
+      free(H->val);
+      G.n = H->n;
+      *H = G;
+   }
+   for ( i = hash_name(name) & (H->cap-1); H->key[i] != NULL; i = (i+1) & (H->cap-1) )
+      if ( strcmp(H->key[i], name) == 0 ) {
+         H->val[i] = v;
+         return;
+      }
+   H->key[i] = xstrdup(name);
+   H->val[i] = v;
+   H->n++;
+}
+
+/// Next line of 'in' into *buf (grown as needed): 0 at the end of the file
+static int read_line(FILE* in, char** buf, int* cap) {
+   int len = 0, c;
+   while ( (c = fgetc(in)) != EOF && c != '\n' ) {
+      if ( len+1 >= *cap ) {
+         *cap = 2*(*cap) + 256;
+         *buf = (char*) xrealloc(*buf, *cap);
+      }
+      (*buf)[len++] = (char) c;
+   }
+   if ( c == EOF && len == 0 )
+      return 0;
+   if ( *cap == 0 ) {
+      *cap = 256;
+      *buf = (char*) xrealloc(*buf, *cap);
+   }
+   (*buf)[len] = '\0';
+   return 1;
+}
+
+/// Split the line in at most 'max' fields separated by blanks
+static int split(char* line, char** tok, int max) {
+   int n = 0;
+   while ( n < max ) {
+      while ( *line && isspace((unsigned char) *line) )
+         line++;
+      if ( !*line )
+         break;
+      tok[n++] = line;
+      while ( *line && !isspace((unsigned char) *line) )
+         line++;
+      if ( *line )
+         *line++ = '\0';
+   }
+   return n;
+}
+
+enum { S_NONE, S_NAME, S_OBJSENSE, S_ROWS, S_COLUMNS, S_RHS, S_RANGES, S_BOUNDS, S_END };
+
+#define OBJ_ROW   -2   /* value of the objective row in the map of the rows */
+#define FREE_ROW  -3   /* other rows 'N': their entries are skipped */
+
+mip_t* mip_read_mps(const char* filename) {
+   FILE*    in = fopen(filename, "r");
+   mip_t*   P = NULL;
+   names_t  rows = { 0, 0, NULL, NULL }, cols = { 0, 0, NULL, NULL };
+   char*    buf = NULL;
+   char*    tok[8];
+   char     last[256] = "";
+   char*    ranged = NULL;
+   double*  range = NULL;
+   int      cap = 0, line = 0, section = S_NONE, integer = 0, nt, i, j, k, p, col = -1;
+   int      has_obj = 0, ok = 0;
+
+   if ( in == NULL ) {
+      fprintf(stderr, "Impossible to open file: %s\n", filename);
+      return NULL;
+   }
+   P = mip_new(NULL);
+   while ( read_line(in, &buf, &cap) ) {
+      line++;
+      if ( buf[0] == '*' )
+         continue;
+      /// A section starts in the first column
+      if ( buf[0] != '\0' && !isspace((unsigned char) buf[0]) ) {
+         nt = split(buf, tok, 8);
+         if ( strcmp(tok[0], "NAME") == 0 ) {
+            section = S_NAME;
+            free(P->name);
+            P->name = xstrdup(nt > 1 ? tok[1] : "");
+         } else if ( strcmp(tok[0], "OBJSENSE") == 0 ) {
+            section = S_OBJSENSE;
+            if ( nt > 1 )
+               P->maximize = (strncmp(tok[1], "MAX", 3) == 0);
+         } else if ( strcmp(tok[0], "ROWS") == 0 )
+            section = S_ROWS;
+         else if ( strcmp(tok[0], "COLUMNS") == 0 )
+            section = S_COLUMNS;
+         else if ( strcmp(tok[0], "RHS") == 0 )
+            section = S_RHS;
+         else if ( strcmp(tok[0], "RANGES") == 0 ) {
+            section = S_RANGES;
+            ranged = (char*) calloc(P->m+1, sizeof(char));
+            range = (double*) calloc(P->m+1, sizeof(double));
+         } else if ( strcmp(tok[0], "BOUNDS") == 0 )
+            section = S_BOUNDS;
+         else if ( strcmp(tok[0], "ENDATA") == 0 ) {
+            section = S_END;
+            break;
+         } else {
+            fprintf(stderr, "%s:%d: unknown section %s\n", filename, line, tok[0]);
+            goto QUIT;
+         }
+         continue;
+      }
+      nt = split(buf, tok, 8);
+      if ( nt == 0 )
+         continue;
+      switch ( section ) {
+      case S_OBJSENSE:
+         P->maximize = (strncmp(tok[0], "MAX", 3) == 0);
+         break;
+
+      case S_ROWS:
+         if ( nt < 2 )
+            goto BAD_LINE;
+         if ( tok[0][0] == 'N' ) {   /// The first 'N' row is the objective
+            names_put(&rows, tok[1], has_obj ? FREE_ROW : OBJ_ROW);
+            has_obj = 1;
+         } else if ( tok[0][0] == 'L' || tok[0][0] == 'E' || tok[0][0] == 'G' )
+            names_put(&rows, tok[1], mip_add_row(P, tok[0][0], 0, tok[1]));
+         else
+            goto BAD_LINE;
+         break;
+
+      case S_COLUMNS:
+         if ( nt >= 3 && strcmp(tok[1], "'MARKER'") == 0 ) {
+            if ( strcmp(tok[2], "'INTORG'") == 0 )
+               integer = 1;
+            else if ( strcmp(tok[2], "'INTEND'") == 0 )
+               integer = 0;
+            else
+               goto BAD_LINE;
+            break;
+         }
+         if ( nt != 3 && nt != 5 )
+            goto BAD_LINE;
+         /// The entries of a column are consecutive
+         if ( col < 0 || strcmp(tok[0], last) != 0 ) {
+            if ( strlen(tok[0]) >= sizeof(last) )
+               goto BAD_LINE;
+            strcpy(last, tok[0]);
+            col = names_get(&cols, tok[0]);
+            if ( col < 0 ) {
+               col = mip_add_col(P, 0, 0, MIP_INFINITY, integer, tok[0]);
+               names_put(&cols, tok[0], col);
+            }
+         }
+         for ( k = 1; k+1 < nt; k += 2 ) {
+            double v = atof(tok[k+1]);
+            i = names_get(&rows, tok[k]);
+            if ( i == OBJ_ROW )
+               P->obj[col] += v;
+            else if ( i >= 0 )
+               mip_add_coef(P, i, col, v);
+            else if ( i != FREE_ROW ) {
+               fprintf(stderr, "%s:%d: unknown row %s\n", filename, line, tok[k]);
+               goto QUIT;
+            }
+         }
+         break;
+
+      case S_RHS:
+      case S_RANGES:
+         /// An odd number of fields: the first is the name of the vector
+         for ( k = nt % 2; k+1 < nt; k += 2 ) {
+            double v = atof(tok[k+1]);
+            i = names_get(&rows, tok[k]);
+            if ( i == OBJ_ROW && section == S_RHS )
+               P->obj_offset = -v;
+            else if ( i >= 0 && section == S_RHS )
+               P->rhs[i] = v;
+            else if ( i >= 0 ) {
+               ranged[i] = 1;
+               range[i] = v;
+            } else if ( i != FREE_ROW && i != OBJ_ROW ) {
+               fprintf(stderr, "%s:%d: unknown row %s\n", filename, line, tok[k]);
+               goto QUIT;
+            }
+         }
+         break;
+
+      case S_BOUNDS: {
+         /// Type, bound vector (optional), column, value (if needed)
+         int    has_value = strcmp(tok[0], "FR") != 0 && strcmp(tok[0], "MI") != 0 &&
+                            strcmp(tok[0], "PL") != 0 && strcmp(tok[0], "BV") != 0;
+         double v = 0;
+         char*  name = NULL;
+         if ( nt < 2 || (has_value && nt < 3) )
+            goto BAD_LINE;
+         if ( has_value ) {
+            name = tok[nt >= 4 ? 2 : 1];
+            v = atof(tok[nt >= 4 ? 3 : 2]);
+         } else
+            name = tok[nt >= 3 ? 2 : 1];
+         j = names_get(&cols, name);
+         if ( j < 0 ) {
+            fprintf(stderr, "%s:%d: unknown column %s\n", filename, line, name);
+            goto QUIT;
+         }
+         if ( strcmp(tok[0], "UP") == 0 || strcmp(tok[0], "UI") == 0 ) {
+            P->ub[j] = v;
+            if ( v < 0 && P->lb[j] == 0 )   /// As in the MPS standard
+               P->lb[j] = -MIP_INFINITY;
+         } else if ( strcmp(tok[0], "LO") == 0 || strcmp(tok[0], "LI") == 0 )
+            P->lb[j] = v;
+         else if ( strcmp(tok[0], "FX") == 0 )
+            P->lb[j] = P->ub[j] = v;
+         else if ( strcmp(tok[0], "FR") == 0 ) {
+            P->lb[j] = -MIP_INFINITY;
+            P->ub[j] = MIP_INFINITY;
+         } else if ( strcmp(tok[0], "MI") == 0 )
+            P->lb[j] = -MIP_INFINITY;
+         else if ( strcmp(tok[0], "PL") == 0 )
+            P->ub[j] = MIP_INFINITY;
+         else if ( strcmp(tok[0], "BV") == 0 ) {
+            P->lb[j] = 0;
+            P->ub[j] = 1;
+         } else
+            goto BAD_LINE;
+         if ( strcmp(tok[0], "LI") == 0 || strcmp(tok[0], "UI") == 0 || strcmp(tok[0], "BV") == 0 )
+            P->is_int[j] = 1;
+         break;
+      }
+
+      default:
+         goto BAD_LINE;
+      }
+   }
+   if ( section != S_END ) {
+      fprintf(stderr, "%s: ENDATA is missing\n", filename);
+      goto QUIT;
+   }
+   /// A ranged row l <= ax <= u becomes the rows ax >= l and ax <= u. The
+   /// triplets are bucketed by row first, to copy the ones of a ranged row
+   if ( ranged != NULL ) {
+      int  m = P->m, nt0 = P->nt;
+      int* beg = (int*) calloc(m+1, sizeof(int));
+      int* trip = (int*) malloc((nt0 > 0 ? nt0 : 1)*sizeof(int));
+      for ( p = 0; p < nt0; ++p )
+         beg[P->ti[p]+1]++;
+      for ( i = 0; i < m; ++i )
+         beg[i+1] += beg[i];
+      for ( p = 0; p < nt0; ++p )
+         trip[beg[P->ti[p]]++] = p;
+      for ( i = m; i > 0; --i )
+         beg[i] = beg[i-1];
+      beg[0] = 0;
+      for ( i = 0; i < m; ++i )
+         if ( ranged[i] && !(P->sense[i] == 'E' && range[i] == 0) ) {
+            double r = (range[i] > 0) ? range[i] : -range[i], b = P->rhs[i];
+            int    h;
+            if ( P->sense[i] == 'E' ) {
+               P->sense[i] = 'G';
+               if ( range[i] < 0 )
+                  P->rhs[i] = b - r;
+               h = mip_add_row(P, 'L', (range[i] < 0) ? b : b + r, P->rname[i]);
+            } else if ( P->sense[i] == 'L' )
+               h = mip_add_row(P, 'G', b - r, P->rname[i]);
+            else
+               h = mip_add_row(P, 'L', b + r, P->rname[i]);
+            for ( p = beg[i]; p < beg[i+1]; ++p )
+               mip_add_coef(P, h, P->tj[trip[p]], P->tv[trip[p]]);
+         }
+      free(beg);
+      free(trip);
+   }
+   if ( P->maximize ) {
+      for ( j = 0; j < P->n; ++j )
+         P->obj[j] = -P->obj[j];
+      P->obj_offset = -P->obj_offset;
+   }
+   mip_build(P);
+   ok = 1;
+   goto QUIT;
+
+BAD_LINE:
+   fprintf(stderr, "%s:%d: bad line\n", filename, line);
+
+QUIT:
+   fclose(in);
+   free(buf);
+   free(ranged);
+   free(range);
+   names_free(&rows);
+   names_free(&cols);
+   if ( !ok ) {
+      mip_free(P);
+      return NULL;
+   }
+   return P;
+}
@@ -0,0 +1,80 @@
+/*
+ *  Main authors:
+ *     Stefano Gualandi <stefano.gualandi@gmail.com>
+ *
+ *  Sparse storage of a (mixed) integer program:
+ *
+ *     min { cx + c0 | Ax (<=, =, >=) b, l <= x <= u, x_j integer for j in I }
+ *
+ *  The rows and the columns are added one at a time, and the arrays grow as
+ *  needed. The coefficients are collected as triplets; mip_build() turns
+ *  them into a row-wise (CSR) and a column-wise (CSC) copy of A, with the
+ *  repeated entries summed and the zeros dropped.
+ *
+ *  Two readers:
+ *   - mip_read_mat() for the dense files of the examples ("n m+1", the cost
+ *     vector, then a row "a_i b_i" for every constraint a_i x <= b_i);
+ *   - mip_read_mps() for the files in (free) MPS format: the sections NAME,
+ *     OBJSENSE, ROWS, COLUMNS (with the INTORG/INTEND markers), RHS, RANGES
+ *     and BOUNDS (UP, LO, FX, FR, MI, PL, BV, LI, UI). A ranged row becomes
+ *     two rows, and a maximization problem is stored as a minimization one,
+ *     with the cost vector negated.
+ */
+
+#ifndef _MIP_H_
+#define _MIP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Infinite bound (the same as LP_INFINITY)
+#define MIP_INFINITY   1e20
+
+typedef struct {
+   char*    name;
+   int      n, m, nz;          /* columns, rows, and coefficients of A */
+   /// Columns
+   double  *obj, *lb, *ub;
+   char    *is_int;
+   char   **cname;
+   double   obj_offset;        /* the constant c0 */
+   int      maximize;          /* 1 if the cost vector was negated */
+   /// Rows: sense 'L', 'E' or 'G'
+   double  *rhs;
+   char    *sense;
+   char   **rname;
+   /// A row-wise and column-wise, after mip_build()
+   int     *rbeg, *rind;
+   double  *rval;
+   int     *cbeg, *cind;
+   double  *cval;
+   /// Coefficients not yet built, and the sizes of the arrays
+   int      nt, tcap, ncap, mcap;
+   int     *ti, *tj;
+   double  *tv;
+} mip_t;
+
+mip_t* mip_new(const char* name);
+void   mip_free(mip_t* P);
+
+/// New column (row): returns its index. 'name' may be NULL
+int    mip_add_col(mip_t* P, double obj, double lb, double ub, int is_int, const char* name);
+int    mip_add_row(mip_t* P, char sense, double rhs, const char* name);
+
+/// A[i][j] += v
+void   mip_add_coef(mip_t* P, int i, int j, double v);
+
+/// Row-wise and column-wise copies of the coefficients added so far
+void   mip_build(mip_t* P);
+
+/// Readers: they return NULL (with a message on stderr) on errors. The
+/// problem is built
+mip_t* mip_read_mat(const char* filename);
+mip_t* mip_read_mps(const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MIP_H_ */